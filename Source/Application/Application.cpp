@@ -5,29 +5,45 @@
 #include "Checkers/CheckersBoard.h"
 #include "Utils/Log/Log.h"
 
+#include <chrono>
+#include <thread>
+
+#if !HEADLESS
+#include <Windows.h>
 #include <SDL_mixer.h>
 #include <SDL_image.h>
+#endif
 
 //--------------------------------------------------------------------------------------------------------------
 // Initialize SDL, Create client or server based on user's choice
+//      - sessionId: Lobby session to join as a client, kInvalidIndex to ask whether to host or join a host
+//      - isWatching: Follow sessionId as a spectator instead of taking a seat
 //--------------------------------------------------------------------------------------------------------------
-bool App::Initialize()
+bool App::Initialize(size_t sessionId, bool isWatching)
 {
-    bool isClient = (IDYES == ::MessageBoxA(NULL, "Would you like to run as a client?", "Client or Server?", MB_YESNO | MB_ICONQUESTION));
+#if HEADLESS
+    // Nobody to ask, a session id makes a client and anything else hosts. The engine plays either way
+    bool isClient = (sessionId != kInvalidIndex);
+    bool isBotPlaying = true;
+#else
+    bool isClient = (sessionId != kInvalidIndex)
+        || (IDYES == ::MessageBoxA(NULL, "Would you like to run as a client?", "Client or Server?", MB_YESNO | MB_ICONQUESTION));
+    bool isBotPlaying = (IDYES == ::MessageBoxA(NULL, "Would you like the engine to play this side?", "Human or Engine?", MB_YESNO | MB_ICONQUESTION));
 
     // SDL
     if (!InitSDL(isClient))
         return false;
+#endif
 
     // Networking
     if (isClient)
-        m_pNetwork =  new NetworkClient(this);
+        m_pNetwork =  new NetworkClient(this, sessionId, isWatching);
     else
         m_pNetwork = new NetworkServer(this);
     m_pNetwork->Initialize();
 
     // Game
-    m_board.Init(m_pRenderer, isClient);
+    m_board.Init(m_pRenderer, isClient, isBotPlaying);
 
     return true;
 }
@@ -50,28 +66,40 @@ void App::Shutdown()
     }
 
     // SDL
+#if !HEADLESS
     if (m_pRenderer) SDL_DestroyRenderer(m_pRenderer);
     if (m_pWindow) SDL_DestroyWindow(m_pWindow);
     Mix_CloseAudio(); 
     Mix_Quit();
     IMG_Quit();
     SDL_Quit();
+#endif
 }
 
 //--------------------------------------------------------------------------------------------------------------
-// Run game loop
+// Run game loop. Networking runs on its own thread, the update only applies what it received.
+// Headless, it ends with the game, nobody is there to restart
 //--------------------------------------------------------------------------------------------------------------
 void App::Run()
 {
     while (m_running)
     {
         HandleInput();
+#if HEADLESS
+        bool gameRunning = m_board.ShouldContinue();
+        m_pNetwork->Update(gameRunning);
+        if (!gameRunning)
+            m_running = false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(kHeadlessDelayMs));
+#else
         RenderWorld(); 
         m_pNetwork->Update(m_board.ShouldContinue());
         SDL_Delay(kDelay);
+#endif
     }
 }
 
+#if !HEADLESS
 //--------------------------------------------------------------------------------------------------------------
 // Init SDL
 //  - Window
@@ -125,12 +153,14 @@ void App::RenderWorld()
     m_board.Render(m_pRenderer);
     SDL_RenderPresent(m_pRenderer);
 }
+#endif
 
 //--------------------------------------------------------------------------------------------------------------
 // Let networking handle SDL event
 //--------------------------------------------------------------------------------------------------------------
 void App::HandleInput()
 {
+#if !HEADLESS
     SDL_Event sdlEvent;
     while (SDL_PollEvent(&sdlEvent))
     {
@@ -145,4 +175,9 @@ void App::HandleInput()
             m_running = m_board.HandleInput(&sdlEvent, m_pNetwork);
         }
     }
+#endif
+
+    // The engine doesn't wait for events
+    if (m_running && m_pNetwork->Active() && m_board.ShouldContinue())
+        m_board.UpdateBot(m_pNetwork);
 }
\ No newline at end of file
@@ -2,9 +2,12 @@
 #include "Checkers/CheckersBoard.h"
 #include "Checkers/CheckersConstants.h"
 
+#include <atomic>
 #include <stdio.h>
 #include <vector>
+#if !HEADLESS
 #include <SDL.h>
+#endif
 
 class NetworkingBase;
 
@@ -13,9 +16,12 @@ class App
 private:
     // Constants
     static constexpr int kDelay = 0;
+    static constexpr int kHeadlessDelayMs = 1;  // Headless, nothing else paces the game loop
 
-    // SDL
+    // SDL, the renderer stays nullptr in a headless build
+#if !HEADLESS
     SDL_Window* m_pWindow = nullptr;
+#endif
     SDL_Renderer* m_pRenderer = nullptr;
 
     // Networking
@@ -23,24 +29,31 @@ private:
 
     // Game
     CheckersBoard m_board;
-    bool m_running = true;
+    std::atomic<bool> m_running{ true };    // The network thread stops us when the connection is gone
 
 public:
-    bool Initialize();
+    bool Initialize(size_t sessionId = kInvalidIndex, bool isWatching = false);
     void Shutdown();
     void Run();
 
     // Networking
-    void Remove(size_t index) { m_board.Remove(index); }
-    void Move(size_t fromIndex, size_t destIndex) { m_board.Move(fromIndex, destIndex); }
-    AllPiecesIndex GetAllPiecesIndex() { return m_board.GetAllPiecesIndex(); }
-    void PlacePiece(CheckersColor side, size_t index) { m_board.PlacePiece(side, index, m_pRenderer); }
+    void PlayMove(const Move& move) { m_board.PlayMove(move); }
+    void ApplySnapshot(const Position& position, size_t moveCount) { m_board.ApplySnapshot(position, moveCount, m_pRenderer); }
+    const Position& GetPosition() const { return m_board.GetPosition(); }
+    size_t GetMoveCount() const { return m_board.GetMoveCount(); }
     void Restart() { m_board.Restart(m_pRenderer); }
+    void SetTurn(CheckersColor side) { m_board.SetTurn(side); }
+    void SetSeat(CheckersColor side) { m_board.SetSeat(side); }
+    ZobristKey GetHash() const { return m_board.GetHash(); }
+    CheckersColor GetWinner() { return m_board.GetWinner(); }
+    void SetWinner(CheckersColor side) { m_board.SetWinner(side); }
     bool Running() const { return m_running; }
-    void Stop() { m_running = false; }  // This is called when I want to stop running but not deleting network stuff yet
+    void Stop() { m_running = false; }  // This is called when I want to stop running but not deleting network stuff yet, from either thread
 
 private:
+#if !HEADLESS
     bool InitSDL(bool isClient);
     void RenderWorld();
+#endif
     void HandleInput();
 };
\ No newline at end of file
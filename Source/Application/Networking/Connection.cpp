@@ -0,0 +1,339 @@
+#include "Connection.h"
+
+#include "Network.h"
+#include "Protocol.h"
+#include "Checkers/CheckersConstants.h"
+
+
+Connection::Connection(SOCKET socket, const std::string& nickname)
+    : m_socket{ socket }
+    , m_nickname{ nickname }
+    , m_incomingBuffer{ kBufferSize }
+    , m_outgoingBuffer{ kBufferSize }
+    , m_outgoingChunks{}
+    , m_outgoingSize{ 0 }
+    , m_encodeBuffer{}
+    , m_isReadingBinary{ false }
+    , m_isWritingBinary{ false }
+    , m_isOverflowing{ false }
+{
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Read everything the socket has, until it would block, straight into the free space of the incoming ring.
+// Returns false if the peer hung up, the socket broke, or the peer sent more than we'll ever hold unread
+//--------------------------------------------------------------------------------------------------------------
+bool Connection::Receive()
+{
+    while (true)
+    {
+        if (m_incomingBuffer.GetFreeSize() == 0)
+        {
+            if (m_incomingBuffer.GetCapacity() >= kMaxIncomingSize)
+            {
+                printf("Dropping %s, too much unread data\n", m_nickname.c_str());
+                return false;
+            }
+            m_incomingBuffer.Reserve(m_incomingBuffer.GetCapacity() * 2);
+        }
+
+        size_t regionSize = 0;
+        char* pRegion = m_incomingBuffer.GetWriteRegion(regionSize);
+        int readBytes = recv(m_socket, pRegion, (int)regionSize, 0);
+        if (readBytes > 0)
+        {
+#if LOG_DATA
+            printf("Received: %d bytes. (prev %d bytes)\n", readBytes, (int)m_incomingBuffer.GetSize());
+#endif
+            m_incomingBuffer.Commit(readBytes);
+            continue;
+        }
+
+        if (readBytes < 0 && IsWouldBlock())
+            return true;
+
+        if (readBytes < 0)
+            printf("Socket error: %d\n", WSAGetLastError());
+        return false;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Send queued bytes until they're all out or the socket would block. Returns false if the socket broke, or the
+// peer let more pile up than we'll hold for it. Our own bytes and broadcasts are gathered into one call, a
+// broadcast isn't copied on the way
+//--------------------------------------------------------------------------------------------------------------
+bool Connection::Send()
+{
+    if (m_isOverflowing)
+        return false;
+
+    while (!m_outgoingChunks.empty())
+    {
+        SendRegion regions[kMaxSendRegions];
+        size_t regionCount = 0;
+        size_t ownOffset = 0;   // Our own bytes of the chunks gathered so far
+
+        // A run of our own bytes takes two regions if it wraps around the ring
+        for (const OutgoingChunk& chunk : m_outgoingChunks)
+        {
+            if (regionCount + 2 > kMaxSendRegions)
+                break;
+
+            if (chunk.m_pShared)
+            {
+                const std::vector<char>& bytes = *chunk.m_pShared;
+                SetRegion(regions[regionCount++], bytes.data() + bytes.size() - chunk.m_size, chunk.m_size);
+                continue;
+            }
+
+            size_t leftSize = chunk.m_size;
+            while (leftSize > 0)
+            {
+                size_t regionSize = 0;
+                const char* pRegion = m_outgoingBuffer.GetReadRegion(regionSize, ownOffset);
+                regionSize = (std::min)(regionSize, leftSize);
+                SetRegion(regions[regionCount++], pRegion, regionSize);
+                ownOffset += regionSize;
+                leftSize -= regionSize;
+            }
+        }
+
+        int sentBytes = SendRegions(m_socket, regions, regionCount);
+        if (sentBytes > 0)
+        {
+#if LOG_DATA
+            printf("Sent %d bytes in %d regions.\n", sentBytes, (int)regionCount);
+#endif
+            OnSent(sentBytes);
+            continue;
+        }
+
+        if (sentBytes < 0 && IsWouldBlock())
+            return true;
+
+        printf("Socket error: %d\n", WSAGetLastError());
+        return false;
+    }
+    return true;
+}
+
+// Drop size sent bytes from the front chunks, and our own from the ring
+void Connection::OnSent(size_t size)
+{
+    while (size > 0)
+    {
+        OutgoingChunk& chunk = m_outgoingChunks.front();
+        size_t chunkSize = (std::min)(size, chunk.m_size);
+        if (!chunk.m_pShared)
+            m_outgoingBuffer.Consume(chunkSize);
+
+        chunk.m_size -= chunkSize;
+        m_outgoingSize -= chunkSize;
+        size -= chunkSize;
+        if (chunk.m_size == 0)
+            m_outgoingChunks.pop_front();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Decode the oldest complete message out of the incoming bytes into message. Returns false if there's none.
+// Protocol lines are handled here, messages we don't know are logged and skipped
+//--------------------------------------------------------------------------------------------------------------
+bool Connection::PopMessage(AnyMessage& message)
+{
+    while (true)
+    {
+        bool isDecoded = false;
+
+        // Frames decode in place, unless they wrap around the end of the ring
+        if (m_isReadingBinary)
+        {
+            if (m_incomingBuffer.IsEmpty())
+                return false;
+
+            size_t frameSize = 1 + (uint8_t)m_incomingBuffer.At(0);
+            if (m_incomingBuffer.GetSize() < frameSize)
+                return false;
+
+            size_t regionSize = 0;
+            const char* pFrame = m_incomingBuffer.GetReadRegion(regionSize);
+            char wrappedFrame[kMaxFrameSize];
+            if (regionSize < frameSize)
+            {
+                m_incomingBuffer.Peek(0, wrappedFrame, frameSize);
+                pFrame = wrappedFrame;
+            }
+
+            isDecoded = DecodeBinary(reinterpret_cast<const uint8_t*>(pFrame) + 1, frameSize - 1, message);
+            m_incomingBuffer.Consume(frameSize);
+        }
+        else
+        {
+            size_t lineSize = m_incomingBuffer.Find('\n');
+            if (lineSize == RingBuffer::kNotFound)
+                return false;
+
+            // No message is that long, it's dropped as unknown
+            char line[kLimit];
+            bool isTooLong = (lineSize >= kLimit);
+            if (!isTooLong)
+                m_incomingBuffer.Peek(0, line, lineSize);
+            m_incomingBuffer.Consume(lineSize + 1);
+
+            if (!isTooLong && OnControlLine(line, lineSize))
+                continue;
+            if (!isTooLong)
+                isDecoded = DecodeText(line, lineSize, message);
+        }
+
+        if (isDecoded)
+            return true;
+
+        Log::Get().PrintInColor(Log::Color::kMagenta, "Unhandled message.\n");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Encode message the way this connection writes, it goes out with the next Send.
+// Returns false if the peer isn't reading what we send, the next Send fails and the owner closes the connection
+//--------------------------------------------------------------------------------------------------------------
+bool Connection::Queue(const Message& message)
+{
+    m_encodeBuffer.clear();
+    if (m_isWritingBinary)
+        EncodeBinary(message, m_encodeBuffer);
+    else
+        EncodeText(message, m_encodeBuffer);
+    return Write(m_encodeBuffer.data(), m_encodeBuffer.size());
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Queue broadcast in the format this connection writes, only a reference to its bytes is kept.
+// Returns false like Queue(message) does
+//--------------------------------------------------------------------------------------------------------------
+bool Connection::Queue(Broadcast& broadcast)
+{
+    const SharedBytes& pBytes = broadcast.GetBytes(m_isWritingBinary);
+    if (pBytes->empty())
+        return !m_isOverflowing;
+
+    if (!Reserve(pBytes->size()))
+        return false;
+    m_outgoingChunks.emplace_back(OutgoingChunk{ pBytes, pBytes->size() });
+    return true;
+}
+
+// Our own bytes, they join the last chunk if it's ours too
+bool Connection::Write(const char* pBytes, size_t size)
+{
+    if (size == 0)
+        return !m_isOverflowing;
+
+    if (!Reserve(size))
+        return false;
+    m_outgoingBuffer.Write(pBytes, size);
+    if (!m_outgoingChunks.empty() && !m_outgoingChunks.back().m_pShared)
+        m_outgoingChunks.back().m_size += size;
+    else
+        m_outgoingChunks.emplace_back(OutgoingChunk{ nullptr, size });
+    return true;
+}
+
+// Count size more bytes going out. Past kMaxOutgoingSize nothing more is taken
+bool Connection::Reserve(size_t size)
+{
+    if (m_isOverflowing)
+        return false;
+
+    if (m_outgoingSize + size > kMaxOutgoingSize)
+    {
+        printf("Dropping %s, too much unsent data\n", m_nickname.c_str());
+        m_isOverflowing = true;
+        return false;
+    }
+    m_outgoingSize += size;
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Client side, ask the server for binary. A server that doesn't know HELLO ignores it and we both stay in text
+//--------------------------------------------------------------------------------------------------------------
+void Connection::OfferBinary()
+{
+    char line[kLimit];
+    sprintf_s(line, kHello.c_str(), kProtocolVersion);
+    Write(line, strlen(line));
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Handle HELLO and BINARY, returns false if the line is anything else, or BINARY with another version.
+// Either one means the peer reads frames, so we switch our writing. BINARY also means it writes them from now on
+//--------------------------------------------------------------------------------------------------------------
+bool Connection::OnControlLine(const char* pLine, size_t length)
+{
+    if (length >= kLimit)
+        return false;
+
+    char line[kLimit];
+    memcpy(line, pLine, length);
+    line[length] = '\0';
+
+    static const std::string kHelloLine = --kHello;
+    static const std::string kBinaryLine = --kBinary;
+
+    size_t version = 0;
+    if (1 == sscanf_s(line, kHelloLine.c_str(), &version))
+    {
+        if (version >= kProtocolVersion)
+            SwitchToBinary();
+        return true;
+    }
+
+    // A version we don't speak is left unhandled, reading its frames as ours would only make garbage
+    if (1 == sscanf_s(line, kBinaryLine.c_str(), &version) && version == kProtocolVersion)
+    {
+        m_isReadingBinary = true;
+        SwitchToBinary();
+        return true;
+    }
+
+    return false;
+}
+
+// Tell the peer with one last line, then write frames
+void Connection::SwitchToBinary()
+{
+    if (m_isWritingBinary)
+        return;
+
+    char line[kLimit];
+    sprintf_s(line, kBinary.c_str(), kProtocolVersion);
+    Write(line, strlen(line));
+    m_isWritingBinary = true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Encode the message for this wire format the first time it's asked for
+//--------------------------------------------------------------------------------------------------------------
+const SharedBytes& Broadcast::GetBytes(bool isBinary)
+{
+    SharedBytes& pBytes = isBinary ? m_pBinary : m_pText;
+    if (!pBytes)
+    {
+        auto pEncoded = std::make_shared<std::vector<char>>();
+        if (isBinary)
+            EncodeBinary(m_message, *pEncoded);
+        else
+            EncodeText(m_message, *pEncoded);
+        pBytes = std::move(pEncoded);
+    }
+    return pBytes;
+}
+
+void Connection::Close()
+{
+    if (m_socket != INVALID_SOCKET)
+        closesocket(m_socket);
+    m_socket = INVALID_SOCKET;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Socket.h"
+#include "RingBuffer.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Message;
+class AnyMessage;
+
+// Encoded bytes shared by every connection sending them, they go away with the last one
+using SharedBytes = std::shared_ptr<const std::vector<char>>;
+
+//--------------------------------------------------------------------------------------------------------------
+// A message going out to many connections. It's encoded at most once per wire format, the first time a connection
+// asks for that one, and each connection's send queue keeps a reference to the bytes instead of a copy
+//--------------------------------------------------------------------------------------------------------------
+class Broadcast
+{
+private:
+    const Message& m_message;
+    SharedBytes m_pText;
+    SharedBytes m_pBinary;
+
+public:
+    explicit Broadcast(const Message& message) : m_message{ message }, m_pText{}, m_pBinary{} {}
+
+    const SharedBytes& GetBytes(bool isBinary);
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// One non-blocking TCP stream of messages, with its own incoming and outgoing bytes.
+// Each direction starts as text lines and may switch to binary frames, see Protocol.h
+//--------------------------------------------------------------------------------------------------------------
+class Connection
+{
+private:
+    // Constants
+    static constexpr size_t kBufferSize = 4096;             // Starting size of each direction, a whole board sync fits
+    static constexpr size_t kMaxIncomingSize = 1 << 20;     // More unread bytes than this and the peer is flooding us
+    static constexpr size_t kMaxOutgoingSize = 1 << 20;     // More unsent bytes than this and the peer stopped reading
+    static constexpr size_t kMaxSendRegions = 16;           // Gathered into one send call
+
+    // A run of outgoing bytes: our own in m_outgoingBuffer, or a broadcast's
+    struct OutgoingChunk
+    {
+        SharedBytes m_pShared;  // Null for our own bytes
+        size_t m_size;          // Not sent yet, a broadcast's are the last ones of it
+    };
+
+    SOCKET m_socket;
+    std::string m_nickname;
+    RingBuffer m_incomingBuffer;
+    RingBuffer m_outgoingBuffer;
+    std::deque<OutgoingChunk> m_outgoingChunks;     // Everything waiting to be sent, in order
+    size_t m_outgoingSize;      // Bytes in m_outgoingChunks
+    std::vector<char> m_encodeBuffer;       // Reused by Queue, one message at a time
+    bool m_isReadingBinary;     // The peer sent kBinary, frames follow
+    bool m_isWritingBinary;     // We sent kBinary
+    bool m_isOverflowing;       // Went past kMaxOutgoingSize, nothing more is queued and Send fails
+
+public:
+    Connection(SOCKET socket, const std::string& nickname);
+
+    SOCKET GetSocket() const { return m_socket; }
+    const std::string& GetNickname() const { return m_nickname; }
+    bool HasIncoming() const { return !m_incomingBuffer.IsEmpty(); }
+    bool HasOutgoing() const { return !m_outgoingChunks.empty(); }
+    bool IsBinary() const { return m_isReadingBinary && m_isWritingBinary; }
+
+    bool Receive();
+    bool Send();
+    bool PopMessage(AnyMessage& message);
+    bool Queue(const Message& message);
+    bool Queue(Broadcast& broadcast);
+    void OfferBinary();
+    void Close();
+
+private:
+    bool Write(const char* pBytes, size_t size);
+    bool Reserve(size_t size);
+    void OnSent(size_t size);
+    bool OnControlLine(const char* pLine, size_t length);
+    void SwitchToBinary();
+};
@@ -0,0 +1,62 @@
+#include "EpollPoller.h"
+
+#ifdef __linux__
+
+EpollPoller::EpollPoller()
+    : m_epoll{ epoll_create1(EPOLL_CLOEXEC) }
+    , m_events{}
+{
+}
+
+EpollPoller::~EpollPoller()
+{
+    if (m_epoll >= 0)
+        ::close(m_epoll);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Register socket for reads and writes at once. Edge-triggered writes only fire when a full send buffer drains,
+// so leaving them on costs nothing
+//--------------------------------------------------------------------------------------------------------------
+bool EpollPoller::Add(SOCKET socket)
+{
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = socket;
+    return epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket, &event) == 0;
+}
+
+void EpollPoller::Remove(SOCKET socket)
+{
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, socket, nullptr);
+}
+
+void EpollPoller::SetWriteInterest(SOCKET, bool)
+{
+    // Always registered, see Add
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Wait for any watched socket, returns how many events were filled
+//--------------------------------------------------------------------------------------------------------------
+size_t EpollPoller::Wait(PollEvent* pEvents, size_t maxEvents, int timeoutMs)
+{
+    if (m_events.size() < maxEvents)
+        m_events.resize(maxEvents);
+
+    int count = epoll_wait(m_epoll, m_events.data(), (int)maxEvents, timeoutMs);
+    if (count <= 0)
+        return 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const epoll_event& event = m_events[i];
+        pEvents[i].m_socket = event.data.fd;
+        pEvents[i].m_isReadable = (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0;
+        pEvents[i].m_isWritable = (event.events & EPOLLOUT) != 0;
+        pEvents[i].m_isError = (event.events & EPOLLERR) != 0;
+    }
+    return (size_t)count;
+}
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#ifdef __linux__
+
+#include "Poller.h"
+
+#include <vector>
+#include <sys/epoll.h>
+
+//--------------------------------------------------------------------------------------------------------------
+// Edge-triggered epoll backend. Sockets are registered once for reads and writes, and a wait only returns
+// the sockets whose readiness changed, so its cost doesn't grow with idle connections
+//--------------------------------------------------------------------------------------------------------------
+class EpollPoller final : public Poller
+{
+private:
+    int m_epoll;
+    std::vector<epoll_event> m_events;      // Filled by epoll_wait, reused between waits
+
+public:
+    EpollPoller();
+    virtual ~EpollPoller() override;
+    EpollPoller(const EpollPoller&) = delete;
+    EpollPoller& operator=(const EpollPoller&) = delete;
+
+    bool IsValid() const { return m_epoll >= 0; }
+
+    virtual bool Add(SOCKET socket) override;
+    virtual void Remove(SOCKET socket) override;
+    virtual void SetWriteInterest(SOCKET socket, bool isInterested) override;
+    virtual size_t Wait(PollEvent* pEvents, size_t maxEvents, int timeoutMs) override;
+};
+
+#endif
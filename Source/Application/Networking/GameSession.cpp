@@ -0,0 +1,242 @@
+#include "GameSession.h"
+
+#include "LobbyServer.h"
+#include "Checkers/CheckersConstants.h"
+
+#include <algorithm>
+#include <random>
+
+//--------------------------------------------------------------------------------------------------------------
+// Token for a seat's RESUME, straight from the system's entropy so seeing other tokens doesn't give it away
+//--------------------------------------------------------------------------------------------------------------
+static unsigned long long MakeResumeToken()
+{
+    static std::random_device s_device;
+
+    unsigned long long token = 0;
+    while (token == 0)
+        token = ((unsigned long long)s_device() << 32) | s_device();
+    return token;
+}
+
+GameSession::GameSession(size_t id, LobbyServer& lobby)
+    : m_id{ id }
+    , m_lobby{ lobby }
+    , m_state{}
+    , m_log{}
+    , m_seats{ INVALID_SOCKET, INVALID_SOCKET }
+    , m_resumeTokens{ 0, 0 }
+    , m_leaveTimes{}
+    , m_spectators{}
+    , m_isWinnerSent{ false }
+{
+    m_state.Init(false);
+}
+
+bool GameSession::IsEmpty() const
+{
+    return m_seats[(size_t)CheckersColor::kDark] == INVALID_SOCKET && m_seats[(size_t)CheckersColor::kLight] == INVALID_SOCKET
+        && m_spectators.empty();
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Give socket the first free seat, dark first, and send it the board from that side. A seat still held for a
+// dropped player isn't free. Returns false if both are taken
+//      - side: the seat it got
+//--------------------------------------------------------------------------------------------------------------
+bool GameSession::Seat(SOCKET socket, CheckersColor& side)
+{
+    for (size_t seat = 0; seat < (size_t)CheckersColor::kCount; ++seat)
+    {
+        if (m_seats[seat] != INVALID_SOCKET || IsHeld(seat))
+            continue;
+
+        m_seats[seat] = socket;
+        m_resumeTokens[seat] = MakeResumeToken();
+        side = (CheckersColor)seat;
+
+        SendTo(side, SeatMessage(seat, m_resumeTokens[seat]));
+        SendBoard(side);
+        return true;
+    }
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Give socket the seat resume asks for and send it what it missed after resume's sequence, or the whole board if
+// the log doesn't reach back that far. Returns false if someone sits there, or the token isn't the seat's
+//--------------------------------------------------------------------------------------------------------------
+bool GameSession::Resume(SOCKET socket, const ResumeMessage& resume)
+{
+    CheckersColor side = (CheckersColor)resume.m_side;
+    size_t lastSequence = resume.m_sequence;
+    if (m_seats[(size_t)side] != INVALID_SOCKET)
+        return false;
+
+    if (m_resumeTokens[(size_t)side] == 0 || resume.m_token != m_resumeTokens[(size_t)side])
+    {
+        Log::Get().PrintInColor(Log::Color::kMagenta, "Session %zd refused a resume with the wrong token.\n", m_id);
+        return false;
+    }
+
+    // A new token each time, the old one is no good to anyone who saw it
+    m_seats[(size_t)side] = socket;
+    m_resumeTokens[(size_t)side] = MakeResumeToken();
+    SendTo(side, SeatMessage((size_t)side, m_resumeTokens[(size_t)side]));
+
+    if (m_log.Covers(lastSequence))
+    {
+        for (size_t sequence = lastSequence + 1; sequence <= m_log.GetLastSequence(); ++sequence)
+            SendTo(side, m_log.Get(sequence));
+        SendTo(side, TurnMessage((size_t)m_state.GetPosition().m_sideToMove));
+        SendTo(side, HashMessage(m_state.GetHash()));
+    }
+    else
+    {
+        SendBoard(side);
+    }
+
+    if (m_isWinnerSent)
+        SendTo(side, WinnerMessage((size_t)m_state.CheckerWinner()));
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Free side's seat, the game stays as it is for whoever takes it next
+//--------------------------------------------------------------------------------------------------------------
+void GameSession::Leave(CheckersColor side)
+{
+    m_seats[(size_t)side] = INVALID_SOCKET;
+    m_leaveTimes[(size_t)side] = std::chrono::steady_clock::now();
+}
+
+// Whether seat's player dropped recently enough to still get it back with its token
+bool GameSession::IsHeld(size_t seat) const
+{
+    return m_resumeTokens[seat] != 0
+        && std::chrono::steady_clock::now() - m_leaveTimes[seat] < std::chrono::milliseconds(kSeatHoldMs);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Let socket follow the game from here on, starting with the whole board
+//--------------------------------------------------------------------------------------------------------------
+void GameSession::Watch(SOCKET socket)
+{
+    m_spectators.emplace_back(socket);
+    m_lobby.SendTo(socket, SnapshotMessage(m_state.GetPosition(), m_state.GetMoveCount(), m_state.GetHash(), m_log.GetLastSequence()));
+    if (m_isWinnerSent)
+        m_lobby.SendTo(socket, WinnerMessage((size_t)m_state.CheckerWinner()));
+}
+
+void GameSession::StopWatching(SOCKET socket)
+{
+    auto it = std::find(m_spectators.begin(), m_spectators.end(), socket);
+    if (it == m_spectators.end())
+        return;
+
+    // Order doesn't matter, the last one takes its place
+    *it = m_spectators.back();
+    m_spectators.pop_back();
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Apply a message from side's seat, what changes the board is echoed to both seats
+//--------------------------------------------------------------------------------------------------------------
+void GameSession::OnMessage(CheckersColor side, const Message& message)
+{
+    // Play, only if it's legal for side. Both seats get it whole and the turn passes with it
+    if (message.type == Message::Type::Play)
+    {
+        if (PlayMove(side, static_cast<const PlayMessage&>(message)))
+        {
+            EndTurn();
+        }
+        else
+        {
+            Log::Get().PrintInColor(Log::Color::kMagenta, "Session %zd rejected an illegal move.\n", m_id);
+            SendBoard(side);
+        }
+    }
+
+    // Restart, only the dark seat may, the same as the host
+    else if (message.type == Message::Type::Restart && side == CheckersColor::kDark)
+    {
+        m_state.Restart();
+        m_isWinnerSent = false;
+
+        RestartMessage restart(m_log.GetNextSequence());
+        m_log.Append(restart);
+        SendToAll(restart);
+        SendToAll(TurnMessage((size_t)m_state.GetPosition().m_sideToMove));
+        SendHash();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Play side's move if it's one of the legal moves, log it and echo it to both seats. Squares are the same for both.
+// Returns false if it isn't legal, or it isn't side's turn
+//--------------------------------------------------------------------------------------------------------------
+bool GameSession::PlayMove(CheckersColor side, const PlayMessage& message)
+{
+    const Position& position = m_state.GetPosition();
+    if (position.m_sideToMove != side || !IsLegalMove(position, message.m_move))
+        return false;
+
+    m_state.PlayMove(message.m_move);
+
+    PlayMessage play(message.m_move, size_t(side == CheckersColor::kDark), m_log.GetNextSequence());
+    m_log.Append(play);
+    SendToAll(play);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Let both seats check their board and whether the game is over
+//--------------------------------------------------------------------------------------------------------------
+void GameSession::EndTurn()
+{
+    SendHash();
+
+    CheckersColor winner = m_state.CheckerWinner();
+    if (winner != CheckersColor::kContinue && !m_isWinnerSent)
+    {
+        SendToAll(WinnerMessage((size_t)winner));
+        m_isWinnerSent = true;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// The whole game in one message, up to the last logged one. The position is in the host's orientation, the client
+// turns it for its seat
+//--------------------------------------------------------------------------------------------------------------
+void GameSession::SendBoard(CheckersColor side)
+{
+    SendTo(side, SnapshotMessage(m_state.GetPosition(), m_state.GetMoveCount(), m_state.GetHash(), m_log.GetLastSequence()));
+}
+
+void GameSession::SendHash()
+{
+    SendToAll(HashMessage(m_state.GetHash()));
+}
+
+void GameSession::SendTo(CheckersColor side, const Message& message)
+{
+    if (m_seats[(size_t)side] != INVALID_SOCKET)
+        m_lobby.SendTo(m_seats[(size_t)side], message);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Both seats and every spectator. The message is encoded once for all of them, each connection only holds on
+// to the bytes until they're sent
+//--------------------------------------------------------------------------------------------------------------
+void GameSession::SendToAll(const Message& message)
+{
+    Broadcast broadcast(message);
+    for (SOCKET socket : m_seats)
+    {
+        if (socket != INVALID_SOCKET)
+            m_lobby.SendTo(socket, broadcast);
+    }
+    for (SOCKET socket : m_spectators)
+        m_lobby.SendTo(socket, broadcast);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Socket.h"
+#include "SessionLog.h"
+#include "Checkers/GameState.h"
+
+#include <chrono>
+#include <vector>
+
+class LobbyServer;
+struct Message;
+struct PlayMessage;
+struct ResumeMessage;
+
+//--------------------------------------------------------------------------------------------------------------
+// One match hosted by the lobby, with its own rules state, two seats and any number of spectators.
+// The state is kept in the dark side's orientation, moves and snapshots travel in it and each seat turns them for itself
+//--------------------------------------------------------------------------------------------------------------
+class GameSession
+{
+private:
+    // Constants
+    static constexpr int kSeatHoldMs = 30000;          // A dropped player's seat waits this long for its RESUME
+
+    size_t m_id;
+    LobbyServer& m_lobby;
+    GameState m_state;
+    SessionLog m_log;                                   // Moves and restarts a dropped seat may have missed
+    SOCKET m_seats[(size_t)CheckersColor::kCount];      // INVALID_SOCKET while nobody sits there
+    unsigned long long m_resumeTokens[(size_t)CheckersColor::kCount];  // Sent with SEAT, RESUME must bring it back. 0 for none
+    std::chrono::steady_clock::time_point m_leaveTimes[(size_t)CheckersColor::kCount];
+    std::vector<SOCKET> m_spectators;                   // Get everything the seats get, play nothing
+    bool m_isWinnerSent;
+
+public:
+    GameSession(size_t id, LobbyServer& lobby);
+
+    size_t GetId() const { return m_id; }
+    bool IsEmpty() const;
+    bool Seat(SOCKET socket, CheckersColor& side);
+    bool Resume(SOCKET socket, const ResumeMessage& resume);
+    void Leave(CheckersColor side);
+    void Watch(SOCKET socket);
+    void StopWatching(SOCKET socket);
+    void OnMessage(CheckersColor side, const Message& message);
+
+private:
+    bool IsHeld(size_t seat) const;
+    bool PlayMove(CheckersColor side, const PlayMessage& message);
+    void EndTurn();
+    void SendBoard(CheckersColor side);
+    void SendHash();
+    void SendTo(CheckersColor side, const Message& message);
+    void SendToAll(const Message& message);
+};
@@ -0,0 +1,366 @@
+#include "LobbyServer.h"
+
+#include "Utils/Log/Log.h"
+#include "Checkers/CheckersConstants.h"
+
+LobbyServer::LobbyServer()
+    : m_pPoller{ Poller::Create() }
+    , m_listener{ INVALID_SOCKET }
+    , m_members{}
+    , m_sessions{}
+    , m_dirtySockets{}
+    , m_backlogSockets{}
+    , m_readySockets{}
+    , m_running{ true }
+{
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Listen on every interface, players reach the lobby from other machines. Returns false if the port is taken
+//--------------------------------------------------------------------------------------------------------------
+bool LobbyServer::Initialize()
+{
+    WSAData wsadata;
+    if (WSAStartup(MAKEWORD(2, 2), &wsadata) != 0)
+        return false;
+
+    m_listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((u_short)kServerPort);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(m_listener, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0
+        || listen(m_listener, SOMAXCONN) != 0)
+    {
+        printf("Socket error: %d\n", WSAGetLastError());
+        return false;
+    }
+
+    // Accepted sockets inherit non-blocking mode, the poller may be edge-triggered so every read drains
+    SetNonBlocking(m_listener);
+    m_pPoller->Add(m_listener);
+
+    Log::Get().PrintInColor(Log::Color::kLightCyan, "Lobby waiting for connections on port %u...\n", kServerPort);
+    return true;
+}
+
+void LobbyServer::Shutdown()
+{
+    for (auto& [socket, member] : m_members)
+        member.m_connection.Close();
+    m_members.clear();
+    m_sessions.clear();
+
+    if (m_listener != INVALID_SOCKET)
+        closesocket(m_listener);
+    m_listener = INVALID_SOCKET;
+
+    WSACleanup();
+}
+
+void LobbyServer::Run()
+{
+    while (m_running)
+        Update();
+
+    Log::Get().PrintInColor(Log::Color::kLightCyan, "Lobby closing with %zd sessions\n", m_sessions.size());
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Wait for ready sockets and only touch those, then send everything the sessions queued
+//--------------------------------------------------------------------------------------------------------------
+void LobbyServer::Update()
+{
+    // Messages left over from last update don't wait for the socket, it may never report them again
+    m_readySockets.swap(m_backlogSockets);
+    for (SOCKET socket : m_readySockets)
+    {
+        auto it = m_members.find(socket);
+        if (it != m_members.end())
+            ReadMessages(it->second);
+    }
+    int timeoutMs = m_readySockets.empty() ? kPollTimeoutMs : 0;
+    m_readySockets.clear();
+
+    PollEvent events[kMaxPollEvents];
+    size_t eventCount = m_pPoller->Wait(events, kMaxPollEvents, timeoutMs);
+
+    for (size_t i = 0; i < eventCount; ++i)
+    {
+        const PollEvent& event = events[i];
+
+        // Do we have pending connections?
+        if (event.m_socket == m_listener)
+        {
+            AcceptConnections();
+            continue;
+        }
+
+        auto it = m_members.find(event.m_socket);
+        if (it == m_members.end())
+            continue;
+        Member& member = it->second;
+
+        // Read
+        if (event.m_isReadable || event.m_isError)
+        {
+            bool isOpen = member.m_connection.Receive();
+            ReadMessages(member);
+
+            if (!isOpen)
+            {
+                CloseConnection(event.m_socket);
+                continue;
+            }
+        }
+
+        // Send what didn't fit last time
+        if (event.m_isWritable && member.m_connection.HasOutgoing())
+        {
+            if (!member.m_connection.Send())
+            {
+                CloseConnection(event.m_socket);
+                continue;
+            }
+            m_pPoller->SetWriteInterest(event.m_socket, member.m_connection.HasOutgoing());
+        }
+    }
+
+    FlushConnections();
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Apply every complete message member received, up to the budget. The rest are read first thing next update
+//--------------------------------------------------------------------------------------------------------------
+void LobbyServer::ReadMessages(Member& member)
+{
+    Connection& conn = member.m_connection;
+
+    size_t messageCount = 0;
+    AnyMessage message;
+    while (messageCount < kMaxMessagesPerUpdate && conn.PopMessage(message))
+    {
+        OnMessage(member, message.Get());
+        ++messageCount;
+    }
+
+    if (messageCount == kMaxMessagesPerUpdate && conn.HasIncoming())
+        m_backlogSockets.emplace_back(conn.GetSocket());
+
+    // Switching to binary is answered while reading
+    if (conn.HasOutgoing())
+        m_dirtySockets.emplace_back(conn.GetSocket());
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Accept every pending connection, the listener may not report them again. They wait for JOIN before playing
+//--------------------------------------------------------------------------------------------------------------
+void LobbyServer::AcceptConnections()
+{
+    while (true)
+    {
+        sockaddr_in remoteAddr;
+        SocketLength remoteAddrLen = sizeof(remoteAddr);
+
+        SOCKET socket = accept(m_listener, reinterpret_cast<sockaddr*>(&remoteAddr), &remoteAddrLen);
+        if (socket == INVALID_SOCKET)
+            return;
+
+        SetNonBlocking(socket);
+        if (!m_pPoller->Add(socket))
+        {
+            closesocket(socket);
+            continue;
+        }
+
+        m_members.emplace(socket, Member{ Connection(socket, inet_ntoa(remoteAddr.sin_addr)), kInvalidIndex, CheckersColor::kDark, false });
+        printf("Accepted new connection from %s:%u\n",
+            inet_ntoa(remoteAddr.sin_addr), ntohs(remoteAddr.sin_port));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Try to send everything queued since the last flush. Whatever doesn't fit waits for a writable event
+//--------------------------------------------------------------------------------------------------------------
+void LobbyServer::FlushConnections()
+{
+    for (SOCKET socket : m_dirtySockets)
+    {
+        auto it = m_members.find(socket);
+        if (it == m_members.end())
+            continue;
+
+        if (!it->second.m_connection.Send())
+        {
+            CloseConnection(socket);
+            continue;
+        }
+        m_pPoller->SetWriteInterest(socket, it->second.m_connection.HasOutgoing());
+    }
+    m_dirtySockets.clear();
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Drop the connection and free its seat. A session nobody sits in or watches any more is gone
+//--------------------------------------------------------------------------------------------------------------
+void LobbyServer::CloseConnection(SOCKET socket)
+{
+    auto it = m_members.find(socket);
+    if (it == m_members.end())
+        return;
+
+    Member& member = it->second;
+    Log::Get().PrintInColor(Log::Color::kMagenta, "Connection lost.\n");
+
+    auto sessionIt = m_sessions.find(member.m_sessionId);
+    if (sessionIt != m_sessions.end())
+    {
+        if (member.m_isSpectator)
+            sessionIt->second->StopWatching(socket);
+        else
+            sessionIt->second->Leave(member.m_side);
+        if (sessionIt->second->IsEmpty())
+        {
+            Log::Get().PrintInColor(Log::Color::kLightGray, "Session %zd closed, %zd left\n", member.m_sessionId, m_sessions.size() - 1);
+            m_sessions.erase(sessionIt);
+        }
+    }
+
+    m_pPoller->Remove(socket);
+    member.m_connection.Close();
+    m_members.erase(it);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// JOIN, RESUME or WATCH before anything else, every other message from a seat goes to the member's session
+//--------------------------------------------------------------------------------------------------------------
+void LobbyServer::OnMessage(Member& member, const Message& message)
+{
+    if (message.type == Message::Type::Join)
+    {
+        Join(member, static_cast<const JoinMessage&>(message).m_sessionId);
+        return;
+    }
+    if (message.type == Message::Type::Resume)
+    {
+        Resume(member, static_cast<const ResumeMessage&>(message));
+        return;
+    }
+    if (message.type == Message::Type::Watch)
+    {
+        Watch(member, static_cast<const WatchMessage&>(message).m_sessionId);
+        return;
+    }
+
+    auto it = m_sessions.find(member.m_sessionId);
+    if (it == m_sessions.end() || member.m_isSpectator)
+    {
+        Log::Get().PrintInColor(Log::Color::kMagenta, "Unhandled message.\n");
+        return;
+    }
+    it->second->OnMessage(member.m_side, message);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Seat member in sessionId, creating the session if it isn't there yet. A full session turns it away
+//--------------------------------------------------------------------------------------------------------------
+void LobbyServer::Join(Member& member, size_t sessionId)
+{
+    // Already playing somewhere
+    if (member.m_sessionId != kInvalidIndex || sessionId == kInvalidIndex)
+    {
+        Log::Get().PrintInColor(Log::Color::kMagenta, "Unhandled message.\n");
+        return;
+    }
+
+    GameSession& session = GetSession(sessionId);
+    if (!session.Seat(member.m_connection.GetSocket(), member.m_side))
+    {
+        SendTo(member.m_connection.GetSocket(), GameFullMessage());
+        return;
+    }
+    member.m_sessionId = sessionId;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Put member back in the seat it lost. A session that closed meanwhile starts over as a join, a seat that is
+// still taken or a token that isn't the seat's turns it away, the old connection may not have been noticed dropping yet
+//--------------------------------------------------------------------------------------------------------------
+void LobbyServer::Resume(Member& member, const ResumeMessage& resume)
+{
+    auto it = m_sessions.find(resume.m_sessionId);
+    if (member.m_sessionId != kInvalidIndex || it == m_sessions.end())
+    {
+        Join(member, resume.m_sessionId);
+        return;
+    }
+
+    CheckersColor side = (CheckersColor)resume.m_side;
+    if (!it->second->Resume(member.m_connection.GetSocket(), resume))
+    {
+        SendTo(member.m_connection.GetSocket(), GameFullMessage());
+        return;
+    }
+    member.m_sessionId = resume.m_sessionId;
+    member.m_side = side;
+    Log::Get().PrintInColor(Log::Color::kLightGray, "Session %zd resumed from %zd\n", resume.m_sessionId, resume.m_sequence);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Add member to sessionId's spectators. Watching a session that isn't there creates it, players may join later
+//--------------------------------------------------------------------------------------------------------------
+void LobbyServer::Watch(Member& member, size_t sessionId)
+{
+    if (member.m_sessionId != kInvalidIndex || sessionId == kInvalidIndex)
+    {
+        Log::Get().PrintInColor(Log::Color::kMagenta, "Unhandled message.\n");
+        return;
+    }
+
+    GetSession(sessionId).Watch(member.m_connection.GetSocket());
+    member.m_sessionId = sessionId;
+    member.m_isSpectator = true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// The session with sessionId, created by the first one asking for it
+//--------------------------------------------------------------------------------------------------------------
+GameSession& LobbyServer::GetSession(size_t sessionId)
+{
+    auto it = m_sessions.find(sessionId);
+    if (it == m_sessions.end())
+    {
+        it = m_sessions.emplace(sessionId, std::make_unique<GameSession>(sessionId, *this)).first;
+        Log::Get().PrintInColor(Log::Color::kLightGray, "Session %zd created, %zd running\n", sessionId, m_sessions.size());
+    }
+    return *it->second;
+}
+
+void LobbyServer::SendTo(SOCKET socket, const Message& message)
+{
+    auto it = m_members.find(socket);
+    if (it == m_members.end())
+        return;
+
+    Connection& conn = it->second.m_connection;
+    if (!conn.HasOutgoing())
+        m_dirtySockets.emplace_back(socket);
+    if (!conn.Queue(message))
+        m_dirtySockets.emplace_back(socket);  // Its Send fails on the flush, which closes it
+}
+
+void LobbyServer::SendTo(SOCKET socket, Broadcast& broadcast)
+{
+    auto it = m_members.find(socket);
+    if (it == m_members.end())
+        return;
+
+    Connection& conn = it->second.m_connection;
+    if (!conn.HasOutgoing())
+        m_dirtySockets.emplace_back(socket);
+    if (!conn.Queue(broadcast))
+        m_dirtySockets.emplace_back(socket);  // Its Send fails on the flush, which closes it
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Network.h"
+#include "Connection.h"
+#include "GameSession.h"
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+//--------------------------------------------------------------------------------------------------------------
+// Headless server hosting many matches in one process. Both players are clients: each sends JOIN with a session
+// id, the session is created on the first join, gets a seat back, and from then on its messages go to that session.
+// A player that lost its connection sends RESUME instead to sit back down where it was, and anyone may WATCH a
+// session without a seat
+//--------------------------------------------------------------------------------------------------------------
+class LobbyServer
+{
+private:
+    // Constants
+    static constexpr int kPollTimeoutMs = 100;      // Nothing else to do between network events
+
+    // A connection, and the session and seat it joined. m_sessionId is kInvalidIndex until it joins one
+    struct Member
+    {
+        Connection m_connection;
+        size_t m_sessionId;
+        CheckersColor m_side;
+        bool m_isSpectator;     // Watching m_sessionId, m_side means nothing
+    };
+
+    std::unique_ptr<Poller> m_pPoller;
+    SOCKET m_listener;
+    std::unordered_map<SOCKET, Member> m_members;
+    std::unordered_map<size_t, std::unique_ptr<GameSession>> m_sessions;
+    std::vector<SOCKET> m_dirtySockets;     // Connections that queued output since the last flush
+    std::vector<SOCKET> m_backlogSockets;   // Connections that used their message budget with bytes still unread
+    std::vector<SOCKET> m_readySockets;     // Last update's backlog, being read now
+    std::atomic<bool> m_running;            // Stop may be called from a signal handler
+
+public:
+    LobbyServer();
+    bool Initialize();
+    void Shutdown();
+    void Run();
+    void Update();
+    void Stop() { m_running = false; }
+
+    // Queue message for socket, it goes out at the end of this update
+    void SendTo(SOCKET socket, const Message& message);
+    void SendTo(SOCKET socket, Broadcast& broadcast);
+    size_t GetSessionCount() const { return m_sessions.size(); }
+
+private:
+    void ReadMessages(Member& member);
+    void AcceptConnections();
+    void FlushConnections();
+    void CloseConnection(SOCKET socket);
+    void OnMessage(Member& member, const Message& message);
+    void Join(Member& member, size_t sessionId);
+    void Resume(Member& member, const ResumeMessage& resume);
+    void Watch(Member& member, size_t sessionId);
+    GameSession& GetSession(size_t sessionId);
+};
@@ -1,14 +1,22 @@
 #pragma once
 
-#define _WINSOCK_DEPRECATED_NO_WARNINGS
-#include <WinSock2.h>
-
+#include "Socket.h"
+#include "Poller.h"
+#include "Checkers/MoveGenerator.h"
+#include "Checkers/Position.h"
 #include "Utils/Log/Log.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <new>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
-#include <queue>
-#include <SDL.h>
 #include <assert.h>
 
 //--------------------------------------------------------------------------------------------------------------
@@ -16,6 +24,9 @@
 //--------------------------------------------------------------------------------------------------------------
 static constexpr const char* pServerIp = "127.0.0.1";
 static constexpr unsigned int kServerPort = 6565;
+static constexpr int kPollTimeoutMs = 1;            // Longest a network update waits for a socket to be ready
+static constexpr size_t kMaxPollEvents = 64;        // Ready sockets handled per wait, the rest stay ready for the next one
+static constexpr size_t kMaxMessagesPerUpdate = 64; // Decoded from one connection per update, several moves fit
 
 //--------------------------------------------------------------------------------------------------------------
 // Events for connections
@@ -25,13 +36,17 @@ struct Message
     enum class Type
     {
         Unknown,
-        Kill,
-        Move,
+        Play,
         GameFull,
-        Active,
-        Piece,
         Turn,
-        Restart
+        Restart,
+        Hash,
+        Winner,
+        Seat,
+        Join,
+        Snapshot,
+        Resume,
+        Watch
     };
 
     Type type;
@@ -44,29 +59,16 @@ struct MessageBase : Message
     MessageBase() { type = MessageType; }
 };
 
-// Remove a piece event
-struct KillMessage : MessageBase<Message::Type::Kill>
-{
-    size_t m_index = 0;
-    size_t m_isHostCalling = 0;
-    KillMessage(size_t index, size_t isHostCalling)
-        : m_index{ index }
-        , m_isHostCalling{ isHostCalling }
-    {        
-        assert(m_isHostCalling == 0 || m_isHostCalling == 1);
-    }
-};
-
-// Move a piece to the destindex event
-struct MoveMessage : MessageBase<Message::Type::Move>
+// A whole move played at once: every square the piece stands on and every piece it jumps. It passes the turn
+struct PlayMessage : MessageBase<Message::Type::Play>
 {
-    size_t m_fromIndex = 0;
-    size_t m_destIndex = 0;
-    size_t m_isHostCalling = 0;    // 0 for client calling, 1 for host calling
-    MoveMessage(size_t fromIndex, size_t destIndex, size_t isHostCalling)
-        : m_fromIndex{ fromIndex }
-        , m_destIndex{ destIndex }
+    Move m_move;                    // Squares in the host's orientation, the same for both seats
+    size_t m_isHostCalling = 0;     // 0 for client calling, 1 for host calling
+    size_t m_sequence = 0;          // Stamped by a lobby session, 0 from players and hosts
+    PlayMessage(const Move& move, size_t isHostCalling, size_t sequence = 0)
+        : m_move{ move }
         , m_isHostCalling{ isHostCalling }
+        , m_sequence{ sequence }
     {
         assert(m_isHostCalling == 0 || m_isHostCalling == 1);
     }
@@ -77,39 +79,223 @@ struct GameFullMessage : MessageBase<Message::Type::GameFull>
 {
 };
 
-// Set active event
-struct ActiveMessage : MessageBase<Message::Type::Active>
+struct RestartMessage : MessageBase<Message::Type::Restart>
 {
+    size_t m_sequence = 0;          // Stamped by a lobby session, 0 from players and hosts
+    RestartMessage(size_t sequence = 0)
+        : m_sequence{ sequence }
+    {
+    }
 };
 
-struct RestartMessage : MessageBase<Message::Type::Restart>
+// Turn
+struct TurnMessage : MessageBase<Message::Type::Turn>
+{
+    size_t m_side = 0;  // 0 for Host/Dark, 1 for Client/Light
+    TurnMessage(size_t side)
+        : m_side{ side }
+    {
+        assert(m_side == 0 || side == 1);
+    }
+};
+
+// Host's position hash
+struct HashMessage : MessageBase<Message::Type::Hash>
 {
+    unsigned long long m_hash = 0;
+    HashMessage(unsigned long long hash)
+        : m_hash{ hash }
+    {
+    }
 };
 
-// Set active event
-struct PieceMessage : MessageBase<Message::Type::Piece>
+// The host's game is over
+struct WinnerMessage : MessageBase<Message::Type::Winner>
 {
     size_t m_side = 0;  // 0 for Host/Dark, 1 for Client/Light
-    size_t m_destIndex = 0;
-    PieceMessage(size_t side, size_t destIndex) 
+    WinnerMessage(size_t side)
         : m_side{ side }
-        , m_destIndex { destIndex } 
     {
         assert(m_side == 0 || side == 1);
     }
 };
 
-// Turn
-struct TurnMessage : MessageBase<Message::Type::Turn>
+// The lobby seated this client
+struct SeatMessage : MessageBase<Message::Type::Seat>
 {
-    size_t m_side = 0;  // 0 for Host/Dark, 1 for Client/Light
-    TurnMessage(size_t side)
+    size_t m_side = 0;              // 0 for Dark, 1 for Light
+    unsigned long long m_token = 0; // Proves a RESUME comes from whoever sat here, 0 when there's nothing to resume
+    SeatMessage(size_t side, unsigned long long token = 0)
         : m_side{ side }
+        , m_token{ token }
+    {
+        assert(m_side == 0 || side == 1);
+    }
+};
+
+// Ask the lobby for a seat in a session
+struct JoinMessage : MessageBase<Message::Type::Join>
+{
+    size_t m_sessionId = 0;
+    JoinMessage(size_t sessionId)
+        : m_sessionId{ sessionId }
+    {
+    }
+};
+
+// The whole game in one message, a client that just sat down replaces its board with it
+struct SnapshotMessage : MessageBase<Message::Type::Snapshot>
+{
+    Position m_position;            // Host's orientation, the same for both seats
+    size_t m_moveCount = 0;         // Moves played since the game started
+    unsigned long long m_hash = 0;  // Host's hash of m_position
+    size_t m_sequence = 0;          // Last stamped message the snapshot includes
+    SnapshotMessage(const Position& position, size_t moveCount, unsigned long long hash, size_t sequence = 0)
+        : m_position{ position }
+        , m_moveCount{ moveCount }
+        , m_hash{ hash }
+        , m_sequence{ sequence }
+    {
+    }
+};
+
+// Take back a seat after losing the connection, and get what was missed since lastSequence
+struct ResumeMessage : MessageBase<Message::Type::Resume>
+{
+    size_t m_sessionId = 0;
+    size_t m_side = 0;              // 0 for Dark, 1 for Light
+    size_t m_sequence = 0;          // Last stamped message applied before the connection dropped
+    unsigned long long m_token = 0; // The seat's token from its last SEAT
+    ResumeMessage(size_t sessionId, size_t side, size_t sequence, unsigned long long token)
+        : m_sessionId{ sessionId }
+        , m_side{ side }
+        , m_sequence{ sequence }
+        , m_token{ token }
     {
         assert(m_side == 0 || side == 1);
     }
 };
 
+// Follow a lobby session without a seat, everything sent to its players comes to us too
+struct WatchMessage : MessageBase<Message::Type::Watch>
+{
+    size_t m_sessionId = 0;
+    WatchMessage(size_t sessionId)
+        : m_sessionId{ sessionId }
+    {
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Any message, held by value. Messages are plain data so holding one is copying its bytes, nothing is allocated
+//--------------------------------------------------------------------------------------------------------------
+class AnyMessage
+{
+private:
+    static constexpr size_t kMaxSize = (std::max)({ sizeof(PlayMessage), sizeof(GameFullMessage),
+        sizeof(TurnMessage), sizeof(RestartMessage), sizeof(HashMessage), sizeof(WinnerMessage), sizeof(SeatMessage),
+        sizeof(JoinMessage), sizeof(SnapshotMessage), sizeof(ResumeMessage), sizeof(WatchMessage) });
+
+    alignas(std::max_align_t) unsigned char m_storage[kMaxSize];
+
+public:
+    AnyMessage() { new (m_storage) Message{ Message::Type::Unknown }; }
+
+    template <typename MessageType> requires std::is_base_of_v<Message, MessageType>
+    explicit AnyMessage(const MessageType& message) { Set(message); }
+
+    const Message& Get() const { return *std::launder(reinterpret_cast<const Message*>(m_storage)); }
+    Message::Type GetType() const { return Get().type; }
+
+    // Copy message in as the type the caller knows it is, nothing is read past its end
+    template <typename MessageType> requires std::is_base_of_v<Message, MessageType>
+    void Set(const MessageType& message)
+    {
+        static_assert(std::is_trivially_copyable_v<MessageType> && sizeof(MessageType) <= kMaxSize);
+        new (m_storage) MessageType(message);
+    }
+
+    // Copy message in, as the type it says it is
+    void Set(const Message& message)
+    {
+        switch (message.type)
+        {
+        case Message::Type::Play:       Store<PlayMessage>(message); break;
+        case Message::Type::GameFull:   Store<GameFullMessage>(message); break;
+        case Message::Type::Turn:       Store<TurnMessage>(message); break;
+        case Message::Type::Restart:    Store<RestartMessage>(message); break;
+        case Message::Type::Hash:       Store<HashMessage>(message); break;
+        case Message::Type::Winner:     Store<WinnerMessage>(message); break;
+        case Message::Type::Seat:       Store<SeatMessage>(message); break;
+        case Message::Type::Join:       Store<JoinMessage>(message); break;
+        case Message::Type::Snapshot:   Store<SnapshotMessage>(message); break;
+        case Message::Type::Resume:     Store<ResumeMessage>(message); break;
+        case Message::Type::Watch:      Store<WatchMessage>(message); break;
+        default:                        new (m_storage) Message{ Message::Type::Unknown }; break;
+        }
+    }
+
+private:
+    template <typename MessageType>
+    void Store(const Message& message)
+    {
+        static_assert(std::is_trivially_copyable_v<MessageType> && sizeof(MessageType) <= kMaxSize);
+        new (m_storage) MessageType(static_cast<const MessageType&>(message));
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Fixed ring of messages handed from one thread to another. One thread pushes and one pops, the two counts are all
+// they share and nothing is locked. Pushing into a full queue fails, the pushing side checks the free size first
+//--------------------------------------------------------------------------------------------------------------
+class MessageQueue
+{
+public:
+    static constexpr size_t kCapacity = 256;    // Power of two, several updates' worth of budget
+
+private:
+    static constexpr size_t kCacheLineSize = 64;
+
+    std::array<AnyMessage, kCapacity> m_messages;
+    alignas(kCacheLineSize) std::atomic<size_t> m_pushCount;   // Written by the pushing thread only
+    alignas(kCacheLineSize) std::atomic<size_t> m_popCount;    // Written by the popping thread only
+
+public:
+    MessageQueue() : m_messages{}, m_pushCount{ 0 }, m_popCount{ 0 } {}
+
+    // From the pushing thread, the popping one can only make more room meanwhile
+    size_t GetFreeSize() const
+    {
+        return kCapacity - (m_pushCount.load(std::memory_order_relaxed) - m_popCount.load(std::memory_order_acquire));
+    }
+
+    // Typed when the caller knows the message's type, see AnyMessage::Set
+    template <typename MessageType>
+    bool Push(const MessageType& message)
+    {
+        size_t pushCount = m_pushCount.load(std::memory_order_relaxed);
+        if (pushCount - m_popCount.load(std::memory_order_acquire) == kCapacity)
+            return false;
+
+        // The message is whole before the popping thread can see it
+        m_messages[pushCount & (kCapacity - 1)].Set(message);
+        m_pushCount.store(pushCount + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(AnyMessage& message)
+    {
+        size_t popCount = m_popCount.load(std::memory_order_relaxed);
+        if (popCount == m_pushCount.load(std::memory_order_acquire))
+            return false;
+
+        // Copied out before the pushing thread may reuse the slot
+        message = m_messages[popCount & (kCapacity - 1)];
+        m_popCount.store(popCount + 1, std::memory_order_release);
+        return true;
+    }
+};
+
 //--------------------------------------------------------------------------------------------------------------
 // Base class for networking
 //--------------------------------------------------------------------------------------------------------------
@@ -119,47 +305,104 @@ class App;
 class NetworkingBase
 {
 protected:
-    std::queue<Message*> m_incomingMessages;
+    MessageQueue m_incomingMessages;    // Decoded by the network thread, applied by the game
+    MessageQueue m_outgoingMessages;    // Sent by the game, encoded and written by the network thread
+    std::deque<AnyMessage> m_unsentMessages;    // Game side, sent while m_outgoingMessages was full. They go first
+    std::deque<AnyMessage> m_unreadMessages;    // Network side, received while m_incomingMessages was full. They go first
+    std::unique_ptr<Poller> m_pPoller;
     App* m_pApp;
-    bool m_active;      // Whether or not this network should handle input
+    std::atomic<bool> m_active;         // Whether or not this network should handle input
     bool m_logTurn;
 
+private:
+    std::thread m_networkThread;
+    std::atomic<bool> m_isNetworkRunning;
+
 public:
     NetworkingBase(App* _pApp) 
-        : m_pApp{ _pApp }
+        : m_unsentMessages{}
+        , m_unreadMessages{}
+        , m_pPoller{ Poller::Create() }
+        , m_pApp{ _pApp }
         , m_active{ true }
         , m_logTurn{ true }
+        , m_networkThread{}
+        , m_isNetworkRunning{ false }
     {}
 
-    virtual ~NetworkingBase()
-    {
-        while (!m_incomingMessages.empty())
-        {
-            Message* pMsg = m_incomingMessages.front();
-            delete pMsg;
-            pMsg = nullptr;
-            m_incomingMessages.pop();
-        }
-    }
+    virtual ~NetworkingBase() = default;
 
     virtual void Initialize() = 0;
     virtual void Shutdown() = 0;
     virtual void Update(bool gameRunning) = 0;
-    virtual void HandleInput(const std::string& instruction) = 0;
+    virtual void HandleInput(const Message& instruction) = 0;
 
     bool Active() const { return m_active; }
-    Message* GetNextMessage()
+    bool GetNextMessage(AnyMessage& message) { return m_incomingMessages.Pop(message); }
+
+protected:
+    // Connections decode on the network thread, we keep what they give us until the game update. While the queue
+    // is full it waits here, in order, for ReceiveUnread to find room
+    template <typename MessageType>
+    void OnMessage(const MessageType& message)
     {
-        if (m_incomingMessages.empty())
-            return nullptr;
-        auto msg = m_incomingMessages.front();
-        m_incomingMessages.pop();
-        return msg;
+        ReceiveUnread();
+        if (!m_unreadMessages.empty() || !m_incomingMessages.Push(message))
+            m_unreadMessages.emplace_back(message);
+    }
+
+    // From the network thread, every update
+    void ReceiveUnread()
+    {
+        while (!m_unreadMessages.empty() && m_incomingMessages.Push(m_unreadMessages.front().Get()))
+            m_unreadMessages.pop_front();
+    }
+
+    // Messages a connection may hand over this update, none while some still wait. The rest stay in the connection
+    size_t GetReadBudget(size_t maxCount)
+    {
+        ReceiveUnread();
+        return m_unreadMessages.empty() ? (std::min)(maxCount, m_incomingMessages.GetFreeSize()) : 0;
+    }
+
+    // From the game, the network thread writes it out on its next pass. While the queue is full it waits with the
+    // game, in order, for SendUnsent to find room
+    template <typename MessageType>
+    void Send(const MessageType& message)
+    {
+        SendUnsent();
+        if (!m_unsentMessages.empty() || !m_outgoingMessages.Push(message))
+            m_unsentMessages.emplace_back(message);
+    }
+
+    // From the game, every update
+    void SendUnsent()
+    {
+        while (!m_unsentMessages.empty() && m_outgoingMessages.Push(m_unsentMessages.front().Get()))
+            m_unsentMessages.pop_front();
+    }
+
+    //--------------------------------------------------------------------------------------------------------------
+    // The sockets belong to a thread of their own from here until StopNetworkThread. It waits on them and nothing
+    // else, so a move goes out within a poll timeout whatever the frame is doing
+    //--------------------------------------------------------------------------------------------------------------
+    void StartNetworkThread()
+    {
+        m_isNetworkRunning = true;
+        m_networkThread = std::thread([this]()
+        {
+            while (m_isNetworkRunning)
+                WinsockUpdate();
+        });
+    }
+
+    void StopNetworkThread()
+    {
+        m_isNetworkRunning = false;
+        if (m_networkThread.joinable())
+            m_networkThread.join();
     }
 
-protected:
-    virtual void OnMessage(const std::string& message) = 0;
     virtual void WinsockUpdate() = 0;
     virtual void GameUpdate(bool gameRunning) = 0;
 };
-
@@ -1,12 +1,27 @@
 #include "NetworkClient.h"
 
+#include "Protocol.h"
 #include "Application/Application.h"
+#include "Checkers/Zobrist.h"
 
-NetworkClient::NetworkClient(App* _pApp)
+NetworkClient::NetworkClient(App* _pApp, size_t sessionId, bool isWatching)
     : NetworkingBase{ _pApp }
-    , m_connection{}
+    , m_sessionId{ sessionId }
+    , m_isWatching{ isWatching }
+    , m_seat{ CheckersColor::kLight }
     , m_connected{ false }
+    , m_isBacklogged{ false }
+    , m_connection{ INVALID_SOCKET, pServerIp }
+    , m_isSeated{ false }
+    , m_resumeSeat{ CheckersColor::kLight }
+    , m_resumeToken{ 0 }
+    , m_lastSequence{ 0 }
+    , m_reconnectAttempts{ 0 }
+    , m_isResuming{ false }
+    , m_reconnectTime{}
 {
+    // TURN says whether we move first, once the whole board is here
+    m_active = false;
     m_logTurn = false;
 }
 
@@ -16,11 +31,23 @@ void NetworkClient::Initialize()
     int result = WSAStartup(MAKEWORD(2, 2), &wsadata);
     if (result > 0)
         return;
-    
-    m_connection = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
 
-    u_long on = 1;
-    ioctlsocket(m_connection, FIONBIO, &on);
+    Connect();
+    StartNetworkThread();
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Start connecting without waiting, the first event on the socket tells how it went
+//--------------------------------------------------------------------------------------------------------------
+void NetworkClient::Connect()
+{
+    SOCKET socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    SetNonBlocking(socket);
+    m_connection = Connection(socket, pServerIp);
+    m_pPoller->Add(socket);
+
+    // Connecting counts as output, the socket turns writable once it's done
+    m_pPoller->SetWriteInterest(socket, true);
 
     sockaddr_in addr;
     memset(&addr, 0, sizeof(addr));
@@ -28,11 +55,14 @@ void NetworkClient::Initialize()
     addr.sin_port = htons((u_short)kServerPort);
     addr.sin_addr.s_addr = inet_addr(pServerIp);
 
-    connect(m_connection, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    connect(socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
 }
 
 void NetworkClient::Shutdown()
 {
+    StopNetworkThread();
+    m_pPoller->Remove(m_connection.GetSocket());
+    m_connection.Close();
     WSACleanup();
 }
 
@@ -47,110 +77,207 @@ void NetworkClient::Update(bool gameRunning)
         m_logTurn = false;
     }
 
-    WinsockUpdate();
+    SendUnsent();
     GameUpdate(gameRunning);
 }
 
 //--------------------------------------------------------------------------------------------------------------
 // Processes the events we care about.  Returns true if we want to exit the program, false if not.
 //--------------------------------------------------------------------------------------------------------------
-void NetworkClient::HandleInput(const std::string& message)
+void NetworkClient::HandleInput(const Message& message)
 {
-    m_outgoingBuffer.insert(m_outgoingBuffer.end(), message.begin(), message.end());
+    Send(message);
 
-    m_active = false;
-    m_outgoingBuffer.insert(m_outgoingBuffer.end(), kActive.begin(), kActive.end());
-    m_logTurn = true;
+    // Our move passes the turn once the host plays it
+    if (message.type == Message::Type::Play)
+        m_active = false;
 }
 
+//--------------------------------------------------------------------------------------------------------------
+// Network thread. Finish connecting, read and dispatch everything that arrived, then send what the game queued
+//--------------------------------------------------------------------------------------------------------------
 void NetworkClient::WinsockUpdate()
 {
-    fd_set reads, writes, excepts;
-    FD_ZERO(&reads);
-    FD_ZERO(&writes);
-    FD_ZERO(&excepts);
-    FD_SET(m_connection, &reads);
-    FD_SET(m_connection, &writes);
-    FD_SET(m_connection, &excepts);
-    if (select(0, &reads, &writes, &excepts, nullptr) <= 0)
-        return;
+    ReceiveUnread();
 
-    // If there is no server when this client launch, quit application
-    if (!FD_ISSET(m_connection, &writes))
+    // What the game sent. Nothing goes out while we're disconnected, the game waits for TURN again
+    AnyMessage outgoing;
+    while (m_outgoingMessages.Pop(outgoing))
     {
-        Log::Get().PrintInColor(Log::Color::kMagenta, "Couldn't found server, quiting...\n");
-        m_pApp->Stop();
-        return;
+        if (m_connection.GetSocket() != INVALID_SOCKET)
+            m_connection.Queue(outgoing.Get());
     }
 
-    // Init connection
-    if (!m_connected && FD_ISSET(m_connection, &writes))
+    // Dropped, try again once it's time
+    if (m_connection.GetSocket() == INVALID_SOCKET)
     {
-        // Receive a message see if the game is full or not
-        Log::Get().PrintInColor(Log::Color::kLightCyan, "Connection established!\n");
-        m_connected = true;
+        if (m_reconnectAttempts > 0 && std::chrono::steady_clock::now() >= m_reconnectTime)
+            Connect();
+        else
+            std::this_thread::sleep_for(std::chrono::milliseconds(kPollTimeoutMs));
         return;
     }
 
-    // Sending
-    if (m_connected && FD_ISSET(m_connection, &writes) && !m_outgoingBuffer.empty())
+    // Messages left over from last update don't wait for the socket, it may never report them again
+    PollEvent event;
+    size_t eventCount = m_pPoller->Wait(&event, 1, m_isBacklogged ? 0 : kPollTimeoutMs);
+
+    // Init connection, the first event tells whether the server was there
+    if (!m_connected)
     {
-        char buffer[64];
-        int bufferSize = min(sizeof(buffer), (int)m_outgoingBuffer.size());
-        memcpy(buffer, m_outgoingBuffer.data(), bufferSize);
+        if (eventCount == 0)
+            return;
 
-        int sentBytes = send(m_connection, buffer, bufferSize, 0);
-        if (sentBytes > 0)
+        // If there is no server when this client launch, quit application. While reconnecting it's one more try
+        if (event.m_isError || GetPendingError(m_connection.GetSocket()) != 0)
         {
-#if LOG_DATA
-            printf("Sent %d/%d bytes.\n", sentBytes, (int)m_outgoingBuffer.size());
-#endif
-            m_outgoingBuffer.erase(m_outgoingBuffer.begin(),
-                m_outgoingBuffer.begin() + sentBytes);
+            if (m_reconnectAttempts > 0)
+            {
+                OnConnectionLost();
+                return;
+            }
+            Log::Get().PrintInColor(Log::Color::kMagenta, "Couldn't found server, quiting...\n");
+            m_pApp->Stop();
+            return;
         }
-        else
-        {
-            if (sentBytes < 0 && !m_active)
-                printf("Socket error: %u\n", ::WSAGetLastError());
 
-            Log::Get().PrintInColor(Log::Color::kMagenta, "Connection lost.\n");
-            closesocket(m_connection);
-            m_connected = false;
-        }
+        OnConnected();
     }
 
     // Readings
-    if (FD_ISSET(m_connection, &reads))
+    if (eventCount > 0 && (event.m_isReadable || event.m_isError))
     {
-        char buffer[8];
-        int readBytes = recv(m_connection, buffer, sizeof(buffer), 0);
-        if (readBytes <= 0 && !m_active) // disconnect or error
+        bool isOpen = m_connection.Receive();
+        isOpen = ReadMessages() && isOpen;
+
+        if (!isOpen)
         {
-            if (readBytes < 0)
-                printf("Socket error: %u\n", ::WSAGetLastError());
+            OnConnectionLost();
+            return;
+        }
+    }
+    else if (m_isBacklogged && !ReadMessages())
+    {
+        OnConnectionLost();
+        return;
+    }
 
-            Log::Get().PrintInColor(Log::Color::kMagenta, "Connection lost.\n");
-            closesocket(m_connection);
-            m_connected = false;
+    // Sending, right away instead of waiting for the socket to say it's writable
+    if (m_connection.HasOutgoing())
+    {
+        if (!m_connection.Send())
+        {
+            OnConnectionLost();
             return;
         }
+        m_pPoller->SetWriteInterest(m_connection.GetSocket(), m_connection.HasOutgoing());
+    }
+}
 
-#if LOG_DATA
-        printf("Received: %d bytes. (prev %d bytes)\n", readBytes, (int)m_incomingBuffer.size());
-#endif
-        m_incomingBuffer.insert(m_incomingBuffer.end(),
-            &buffer[0], &buffer[readBytes]);
+//--------------------------------------------------------------------------------------------------------------
+// A server that speaks binary switches on its reply, a lobby seats us once it knows which session we want.
+// After a drop the lobby gets our old seat and the last message we applied instead, a host sends its board on accept.
+// A spectator asks to watch every time, the lobby sends it the whole board
+//--------------------------------------------------------------------------------------------------------------
+void NetworkClient::OnConnected()
+{
+    Log::Get().PrintInColor(Log::Color::kLightCyan, "Connection established!\n");
+    m_connected = true;
+    m_isResuming = (m_reconnectAttempts > 0);
+
+    m_connection.OfferBinary();
+    if (m_isWatching)
+        m_connection.Queue(WatchMessage(m_sessionId));
+    else if (m_isResuming && m_isSeated)
+        m_connection.Queue(ResumeMessage(m_sessionId, (size_t)m_resumeSeat, m_lastSequence, m_resumeToken));
+    else if (m_sessionId != kInvalidIndex)
+        m_connection.Queue(JoinMessage(m_sessionId));
+    m_pPoller->SetWriteInterest(m_connection.GetSocket(), m_connection.HasOutgoing());
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Hand every complete message received to the game, up to the budget. The rest are read first thing next update.
+// Returns false if the lobby turned our resume away, the connection is no use then
+//--------------------------------------------------------------------------------------------------------------
+bool NetworkClient::ReadMessages()
+{
+    // Whatever the queue can't take stays in the connection until there's room
+    size_t budget = GetReadBudget(kMaxMessagesPerUpdate);
+    size_t messageCount = 0;
+    AnyMessage message;
+    while (messageCount < budget && m_connection.PopMessage(message))
+    {
+        if (!OnReceived(message.Get()))
+            return false;
+        OnMessage(message.Get());
+        ++messageCount;
+    }
+
+    m_isBacklogged = (messageCount == budget && m_connection.HasIncoming());
+    return true;
+}
 
-        auto newline = std::find(m_incomingBuffer.begin(), m_incomingBuffer.end(), '\n');
-        if (newline == m_incomingBuffer.end())
-            return; // no full message yet
+//--------------------------------------------------------------------------------------------------------------
+// Keep what getting back in after a drop needs, before the game has the message. Everything received gets
+// applied, so the last sequence received is the one to resume from. Returns false if our seat is still taken,
+// the other end hasn't noticed we dropped yet
+//--------------------------------------------------------------------------------------------------------------
+bool NetworkClient::OnReceived(const Message& message)
+{
+    switch (message.type)
+    {
+    case Message::Type::Play:
+        m_lastSequence = static_cast<const PlayMessage&>(message).m_sequence;
+        break;
+    case Message::Type::Restart:
+        m_lastSequence = static_cast<const RestartMessage&>(message).m_sequence;
+        break;
+    case Message::Type::Snapshot:
+        m_lastSequence = static_cast<const SnapshotMessage&>(message).m_sequence;
+        m_isResuming = false;
+        m_reconnectAttempts = 0;
+        break;
+    case Message::Type::Seat:
+        m_resumeSeat = (CheckersColor)static_cast<const SeatMessage&>(message).m_side;
+        m_resumeToken = static_cast<const SeatMessage&>(message).m_token;
+        m_isSeated = true;
+        m_isResuming = false;
+        m_reconnectAttempts = 0;
+        break;
+    case Message::Type::GameFull:
+        return !m_isResuming;
+    default:
+        break;
+    }
+    return true;
+}
 
-        std::string msg;
-        msg.assign(m_incomingBuffer.begin(), newline);
-        m_incomingBuffer.erase(m_incomingBuffer.begin(), newline + 1);
+//--------------------------------------------------------------------------------------------------------------
+// Close the socket and try again in a moment, nothing is played until the board is back in sync
+//--------------------------------------------------------------------------------------------------------------
+void NetworkClient::OnConnectionLost()
+{
+    Log::Get().PrintInColor(Log::Color::kMagenta, "Connection lost.\n");
+    m_pPoller->Remove(m_connection.GetSocket());
+    m_connection.Close();
+    m_connected = false;
+    m_isBacklogged = false;
+    m_isResuming = false;
+    m_active = false;
 
-        OnMessage(msg);
+    if (m_reconnectAttempts < kMaxReconnectAttempts)
+    {
+        ++m_reconnectAttempts;
+        m_reconnectTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(kReconnectDelayMs);
+        Log::Get().PrintInColor(Log::Color::kLightGray, "Reconnecting (%zd/%zd)...\n", m_reconnectAttempts, kMaxReconnectAttempts);
+        return;
     }
+    Log::Get().PrintInColor(Log::Color::kMagenta, "Couldn't reconnect, giving up.\n");
+
+#if HEADLESS
+    // Nobody is watching the board, there's nothing left to do
+    m_pApp->Stop();
+#endif
 }
 
 //--------------------------------------------------------------------------------------------------------------
@@ -168,30 +295,22 @@ void NetworkClient::GameUpdate(bool gameRunning)
 
     while (m_pApp->Running() && gameRunning)
     {
-        Message* msg = GetNextMessage();
-        if (!msg)
+        AnyMessage message;
+        if (!GetNextMessage(message))
         {
             break;
         }
+        const Message* msg = &message.Get();
 
-        // Remove
-        if (msg->type == Message::Type::Kill)
-        {
-            auto* pKill = static_cast<KillMessage*>(msg);
-            m_pApp->Remove(pKill->m_index);
-            Log::Get().PrintInColor(Log::Color::kLightGray, "REMOVED ");
-            Log::Get().PrintInColor(Log::Color::kLightGreen, "%zd\n", pKill->m_index);
-        }
-
-        // Move
-        if (msg->type == Message::Type::Move)
+        // Play, a whole move the host accepted. Whoever didn't make it has the turn now
+        if (msg->type == Message::Type::Play)
         {
-            auto* pMove = static_cast<MoveMessage*>(msg);
-            m_pApp->Move(pMove->m_fromIndex, pMove->m_destIndex);
-            Log::Get().PrintInColor(Log::Color::kLightGray, "MOVED ");
-            Log::Get().PrintInColor(Log::Color::kLightGreen, "%zd", pMove->m_fromIndex);
-            Log::Get().PrintInColor(Log::Color::kLightGray, " TO ");
-            Log::Get().PrintInColor(Log::Color::kLightGreen, "%zd\n", pMove->m_destIndex);
+            auto* pPlay = static_cast<const PlayMessage*>(msg);
+            m_pApp->PlayMove(pPlay->m_move);
+            m_active = IsOurTurn(m_pApp->GetPosition().m_sideToMove);
+            m_logTurn = true;
+            Log::Get().PrintInColor(Log::Color::kLightGray, "PLAYED ");
+            Log::Get().PrintInColor(Log::Color::kLightGreen, "%s\n", MoveToString(pPlay->m_move).c_str());
         }
 
         // Full
@@ -202,25 +321,30 @@ void NetworkClient::GameUpdate(bool gameRunning)
             Log::Get().PrintInColor(Log::Color::kMagenta, "Game is full, quiting...\n");
         }
 
-        // Active
-        if (msg->type == Message::Type::Active)
+        // Turn
+        if (msg->type == Message::Type::Turn)
         {
-            m_active = true;
+            auto* pTurn = static_cast<const TurnMessage*>(msg);
+            m_active = IsOurTurn((CheckersColor)pTurn->m_side);
             m_logTurn = true;
+            m_pApp->SetTurn((CheckersColor)pTurn->m_side);
         }
 
-        // Place Piece
-        if (msg->type == Message::Type::Piece)
+        // Snapshot, the whole board and turn at once
+        if (msg->type == Message::Type::Snapshot)
         {
-            auto* pPiece = static_cast<PieceMessage*>(msg);
-            m_pApp->PlacePiece((CheckersColor)pPiece->m_side, pPiece->m_destIndex);
-        }
-
-        // Turn
-        if (msg->type == Message::Type::Turn)
-        {
-            auto* pTurn = static_cast<TurnMessage*>(msg);
-            m_active = pTurn->m_side;
+            // The hash must be the position's, or the snapshot got mangled on the way and is kept off the board
+            auto* pSnapshot = static_cast<const SnapshotMessage*>(msg);
+            unsigned long long hash = ComputeHash(pSnapshot->m_position);
+            if (pSnapshot->m_hash != hash)
+            {
+                Log::Get().PrintInColor(Log::Color::kMagenta, "Desync: snapshot hash %llx, ", pSnapshot->m_hash);
+                Log::Get().PrintInColor(Log::Color::kMagenta, "its position hashes to %llx\n", hash);
+                continue;
+            }
+
+            m_pApp->ApplySnapshot(pSnapshot->m_position, pSnapshot->m_moveCount);
+            m_active = IsOurTurn(pSnapshot->m_position.m_sideToMove);
             m_logTurn = true;
         }
 
@@ -228,42 +352,37 @@ void NetworkClient::GameUpdate(bool gameRunning)
         if (msg->type == Message::Type::Restart)
         {
             m_pApp->Restart();
+            m_active = IsOurTurn(m_pApp->GetPosition().m_sideToMove);
+            m_logTurn = true;
             Log::Get().PrintInColor(Log::Color::kLightCyan, "Game Restarted\n");
         }
 
-        delete msg;
-        msg = nullptr;
-    }
-}
-
-void NetworkClient::OnMessage(const std::string& message)
-{
-    size_t side = kInvalidIndex;
-    size_t fromIndex = kInvalidIndex;
-    size_t destIndex = kInvalidIndex;
-    size_t isHostCalling = 0;
-
-    if (2 == sscanf_s(message.c_str(), (--kKill).c_str(), &destIndex, &isHostCalling))
-        m_incomingMessages.emplace(new KillMessage(destIndex, isHostCalling));
-
-    else if (3 == sscanf_s(message.c_str(), (--kMove).c_str(), &fromIndex, &destIndex, &isHostCalling))
-        m_incomingMessages.emplace(new MoveMessage(fromIndex, destIndex, isHostCalling));
-
-    else if (message.compare(--kGameFull) == 0)
-        m_incomingMessages.emplace(new GameFullMessage());
-
-    else if (message.compare(--kActive) == 0)
-        m_incomingMessages.emplace(new ActiveMessage());
-
-    else if (2 == sscanf_s(message.c_str(), (--kPiece).c_str(), &side, &destIndex))
-        m_incomingMessages.emplace(new PieceMessage(side, destIndex));
-
-    else if (1 == sscanf_s(message.c_str(), (--kTurn).c_str(), &side))
-        m_incomingMessages.emplace(new TurnMessage(side));
+        // Seat, the board is shown from this side's point of view
+        if (msg->type == Message::Type::Seat)
+        {
+            auto* pSeat = static_cast<const SeatMessage*>(msg);
+            m_seat = (CheckersColor)pSeat->m_side;
+            m_pApp->SetSeat(m_seat);
+            Log::Get().PrintInColor(Log::Color::kLightGray, "Seated on the ");
+            Log::Get().PrintInColor(Log::Color::kLightCyan, "%s side\n", (m_seat == CheckersColor::kDark) ? "dark" : "light");
+        }
 
-    else if (message.compare(--kRestart) == 0)
-        m_incomingMessages.emplace(new RestartMessage());
+        // Game over, the host may have called it before we could tell
+        if (msg->type == Message::Type::Winner)
+        {
+            auto* pWinner = static_cast<const WinnerMessage*>(msg);
+            m_pApp->SetWinner((CheckersColor)pWinner->m_side);
+        }
 
-    else
-        Log::Get().PrintInColor(Log::Color::kMagenta, "Unhandled message.\n");
-}
\ No newline at end of file
+        // Desync check, every change before this message has already been applied
+        if (msg->type == Message::Type::Hash)
+        {
+            auto* pHash = static_cast<const HashMessage*>(msg);
+            if (pHash->m_hash != m_pApp->GetHash())
+            {
+                Log::Get().PrintInColor(Log::Color::kMagenta, "Desync: host hash %llx, ", pHash->m_hash);
+                Log::Get().PrintInColor(Log::Color::kMagenta, "client hash %llx\n", (unsigned long long)m_pApp->GetHash());
+            }
+        }
+    }
+}
@@ -1,31 +1,59 @@
 #pragma once
 
 #include "Network.h"
+#include "Connection.h"
+#include "Checkers/CheckersConstants.h"
+
+#include <chrono>
 
 //--------------------------------------------------------------------------------------------------------------
 // TCP client
-// Also the light piece player
+// The light piece player of a host, either side of a lobby session, or a spectator of one.
+// A dropped connection is retried a few times, a lobby gives the seat back with what was missed while away.
+// The connection lives on the network thread, the board on the game's
 //--------------------------------------------------------------------------------------------------------------
 class NetworkClient final : public NetworkingBase
 {
 private:
-    // Connections
+    // Constants
+    static constexpr int kReconnectDelayMs = 1000;          // Between tries to get a dropped connection back
+    static constexpr size_t kMaxReconnectAttempts = 10;     // Then the game is given up
+
+    // Set once, read by both threads
+    const size_t m_sessionId;   // Lobby session to join, kInvalidIndex when playing against a host
+    const bool m_isWatching;    // Spectating m_sessionId, it's never our turn
+
+    // Game thread
+    CheckersColor m_seat;       // Light against a host, the lobby may seat us on either side
+
+    // Network thread
     bool m_connected;
-    SOCKET m_connection;
+    bool m_isBacklogged;        // Used the message budget last update with bytes still unread
+    Connection m_connection;
+    bool m_isSeated;            // The lobby gave us m_resumeSeat, a new connection asks for it back
+    CheckersColor m_resumeSeat;
+    unsigned long long m_resumeToken;   // From the lobby's SEAT, the lobby won't give the seat back without it
 
-    // Client data
-    std::vector<char> m_incomingBuffer;
-    std::vector<char> m_outgoingBuffer;
+    // Reconnecting, network thread
+    size_t m_lastSequence;                                  // Last stamped message received, every one of them gets applied
+    size_t m_reconnectAttempts;                             // Since the connection dropped, 0 while the board is in sync
+    bool m_isResuming;                                      // Connected again, waiting for the seat and board
+    std::chrono::steady_clock::time_point m_reconnectTime;  // When to try the next one
 
 public:
-    NetworkClient(App* _pApp);
+    NetworkClient(App* _pApp, size_t sessionId = kInvalidIndex, bool isWatching = false);
     virtual void Initialize() override;
     virtual void Shutdown() override;
     virtual void Update(bool gameRunning) override;
-    virtual void HandleInput(const std::string& instruction) override;
+    virtual void HandleInput(const Message& instruction) override;
 
 private:
     virtual void WinsockUpdate() override;
     virtual void GameUpdate(bool gameRunning) override;
-    virtual void OnMessage(const std::string& message) override;
+    bool IsOurTurn(CheckersColor sideToMove) const { return !m_isWatching && sideToMove == m_seat; }
+    void Connect();
+    void OnConnected();
+    bool ReadMessages();
+    bool OnReceived(const Message& message);
+    void OnConnectionLost();
 };
@@ -1,12 +1,21 @@
 #include "NetworkServer.h"
 
+#include "Protocol.h"
 #include "Application/Application.h"
 #include "Utils/Log/Log.h"
 #include "Checkers/CheckersConstants.h"
 
 NetworkServer::NetworkServer(App* _pApp)
     : NetworkingBase{ _pApp }
+    , m_hostMessages{}
+    , m_isWinnerSent{ false }
+    , m_listener{ INVALID_SOCKET }
     , m_connections{}
+    , m_dirtySockets{}
+    , m_backlogSockets{}
+    , m_readySockets{}
+    , m_clientSocket{ INVALID_SOCKET }
+    , m_isClientJoining{ false }
 {
 }
 
@@ -35,19 +44,27 @@ void NetworkServer::Initialize()
         printf("Socket error: %d\n", socketError);
     }
     
-    FD_ZERO(&m_socketFDs);
-    FD_SET(m_listener, &m_socketFDs);
+    // Accepted sockets inherit non-blocking mode, the poller may be edge-triggered so every read drains
+    SetNonBlocking(m_listener);
+    m_pPoller->Add(m_listener);
 
+#if !HEADLESS
     Log::Get().PrintInColor(Log::Color::kLightGray, "You can press '");
     Log::Get().PrintInColor(Log::Color::kLightCyan, "%c", kRestartKey);
     Log::Get().PrintInColor(Log::Color::kLightGray, "' to restart\n");
+#endif
     Log::Get().PrintInColor(Log::Color::kLightCyan, "Waiting for connections...\n");
+
+    StartNetworkThread();
 }
 
 void NetworkServer::Shutdown()
 {
-    for (auto& conn : m_connections)
-        closesocket(conn.socket);
+    StopNetworkThread();
+
+    for (auto& [socket, conn] : m_connections)
+        conn.Close();
+    m_connections.clear();
 
     closesocket(m_listener);
     
@@ -65,132 +82,187 @@ void NetworkServer::Update(bool gameRunning)
         m_logTurn = false;
     }
 
-    WinsockUpdate();
+    SendUnsent();
     GameUpdate(gameRunning);
 }
 
 //--------------------------------------------------------------------------------------------------------------
 // Processes the events we care about.  Returns true if we want to exit the program, false if not.
 //--------------------------------------------------------------------------------------------------------------
-void NetworkServer::HandleInput(const std::string& message)
+void NetworkServer::HandleInput(const Message& message)
 {
-    OnMessage(message);
+    m_hostMessages.emplace_back(message);
 
-    // Send message to the client that to set active
-    if (message.compare(kRestart) != 0)
-    {
-        char activeMsg[kLimit];
+    // Our move is sent, wait for it to be played
+    if (message.type == Message::Type::Play)
         m_active = false;
-        sprintf_s(activeMsg, kActive.c_str());
-        SendToAll(activeMsg);
-        m_logTurn = true;
-    }
 }
 
+//--------------------------------------------------------------------------------------------------------------
+// Network thread. Wait for ready sockets and only touch those: accept, read and dispatch, or send what's left
+// over. Then send what the game queued meanwhile
+//--------------------------------------------------------------------------------------------------------------
 void NetworkServer::WinsockUpdate()
 {
-    timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = 1000; // 1ms
+    ReceiveUnread();
 
-    fd_set reads = m_socketFDs, writes = m_socketFDs, excepts = m_socketFDs;
-    if (select(0, &reads, &writes, &excepts, &tv) <= 0)
-        return; // nothing to do with sockets this update
+    // Messages left over from last update don't wait for the socket, it may never report them again
+    m_readySockets.swap(m_backlogSockets);
+    for (SOCKET socket : m_readySockets)
+    {
+        auto it = m_connections.find(socket);
+        if (it != m_connections.end())
+            ReadMessages(it->second);
+    }
+    int timeoutMs = m_readySockets.empty() ? kPollTimeoutMs : 0;
+    m_readySockets.clear();
+
+    PollEvent events[kMaxPollEvents];
+    size_t eventCount = m_pPoller->Wait(events, kMaxPollEvents, timeoutMs);
 
-    // Do we have a pending connection?
-    if (FD_ISSET(m_listener, &reads))
+    for (size_t i = 0; i < eventCount; ++i)
     {
-        sockaddr_in remoteAddr;
-        int remoteAddrLen = sizeof(remoteAddr);
+        const PollEvent& event = events[i];
 
-        Connection conn;
-        conn.socket = accept(m_listener,
-            reinterpret_cast<sockaddr*>(&remoteAddr), &remoteAddrLen);
-        if (conn.socket != INVALID_SOCKET)
+        // Do we have pending connections?
+        if (event.m_socket == m_listener)
         {
-            conn.nickname = inet_ntoa(remoteAddr.sin_addr);
-            m_connections.emplace_back(conn);
-            FD_SET(conn.socket, &m_socketFDs);
-            printf("Accepted new connection from %s:%u\n",
-                inet_ntoa(remoteAddr.sin_addr), ntohs(remoteAddr.sin_port));
-
-            OnConnectionEstablished(*m_connections.rbegin());
+            AcceptConnections();
+            continue;
         }
-    }
 
-    for (size_t i = 0; i < m_connections.size();)
-    {
-        auto& conn = m_connections[i];
+        auto it = m_connections.find(event.m_socket);
+        if (it == m_connections.end())
+            continue;
+        Connection& conn = it->second;
 
         // Read
-        if (FD_ISSET(conn.socket, &reads))
+        if (event.m_isReadable || event.m_isError)
         {
-            char buffer[8];
-            int readBytes = recv(conn.socket, buffer, sizeof(buffer), 0);
-            if (readBytes <= 0) // disconnect or error
+            bool isOpen = conn.Receive();
+            ReadMessages(conn);
+
+            if (!isOpen)
             {
-                if (readBytes < 0)
-                {
-                    printf("Socket error: %u\n", ::WSAGetLastError());
-                }
+                Log::Get().PrintInColor(Log::Color::kMagenta, "Connection lost.\n");
+                CloseConnection(event.m_socket);
+                continue;
+            }
+        }
 
+        // Send what didn't fit last time
+        if (event.m_isWritable && conn.HasOutgoing())
+        {
+            if (!conn.Send())
+            {
                 Log::Get().PrintInColor(Log::Color::kMagenta, "Connection lost.\n");
-                closesocket(conn.socket);
-                FD_CLR(conn.socket, &m_socketFDs);
-                m_connections.erase(m_connections.begin() + i);
+                CloseConnection(event.m_socket);
                 continue;
             }
+            m_pPoller->SetWriteInterest(event.m_socket, conn.HasOutgoing());
+        }
+    }
 
-#if LOG_DATA
-            printf("Received: %d bytes. (prev %d bytes)\n", readBytes, (int)conn.incomingBuffer.size());
-#endif
-            conn.incomingBuffer.insert(conn.incomingBuffer.end(),
-                &buffer[0], &buffer[readBytes]);
+    SendQueuedMessages();
+    FlushConnections();
+}
 
-            auto newline = std::find(conn.incomingBuffer.begin(), conn.incomingBuffer.end(), '\n');
-            if (newline == conn.incomingBuffer.end())
-                continue; // no full message yet
+//--------------------------------------------------------------------------------------------------------------
+// Queue every complete message conn received, up to the budget. The rest are read first thing next update.
+// Only the seated client is listened to, an extra connection was told the game is full and plays nothing.
+// All the client does is play light, restarting is the host's and its join is queued when it connects
+//--------------------------------------------------------------------------------------------------------------
+void NetworkServer::ReadMessages(Connection& conn)
+{
+    // Whatever the queue can't take stays in the connection until there's room
+    size_t budget = GetReadBudget(kMaxMessagesPerUpdate);
+    size_t messageCount = 0;
+    AnyMessage message;
+    bool isClient = (conn.GetSocket() == m_clientSocket);
+    while (messageCount < budget && conn.PopMessage(message))
+    {
+        const Message& received = message.Get();
+        bool isClientMove = (received.type == Message::Type::Play && !static_cast<const PlayMessage&>(received).m_isHostCalling);
+        if (isClient && isClientMove)
+            OnMessage(received);
+        ++messageCount;
+    }
 
-            std::string msg;
-            msg.assign(conn.incomingBuffer.begin(), newline);
-            conn.incomingBuffer.erase(conn.incomingBuffer.begin(), newline + 1);
+    if (messageCount == budget && conn.HasIncoming())
+        m_backlogSockets.emplace_back(conn.GetSocket());
 
-            OnMessage(msg);
-        }
+    // Switching to binary is answered while reading
+    if (conn.HasOutgoing())
+        m_dirtySockets.emplace_back(conn.GetSocket());
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Accept every pending connection, the listener may not report them again
+//--------------------------------------------------------------------------------------------------------------
+void NetworkServer::AcceptConnections()
+{
+    while (true)
+    {
+        sockaddr_in remoteAddr;
+        SocketLength remoteAddrLen = sizeof(remoteAddr);
 
-        // Send
-        if (FD_ISSET(conn.socket, &writes) && !conn.outgoingBuffer.empty())
+        SOCKET socket = accept(m_listener, reinterpret_cast<sockaddr*>(&remoteAddr), &remoteAddrLen);
+        if (socket == INVALID_SOCKET)
+            return;
+
+        SetNonBlocking(socket);
+        if (!m_pPoller->Add(socket))
         {
-            char buffer[8];
-            int bufferSize = min(sizeof(buffer), (int)conn.outgoingBuffer.size());
-            memcpy(buffer, conn.outgoingBuffer.data(), bufferSize);
+            closesocket(socket);
+            continue;
+        }
 
-            int sentBytes = send(conn.socket, buffer, bufferSize, 0);
-            if (sentBytes > 0)
-            {
-#if LOG_DATA
-                printf("Sent %d/%d bytes.\n", sentBytes, (int)conn.outgoingBuffer.size());
-#endif
-                conn.outgoingBuffer.erase(conn.outgoingBuffer.begin(),
-                    conn.outgoingBuffer.begin() + sentBytes);
-            }
-            else
-            {
-                if (sentBytes < 0)
-                {
-                    printf("Socket error: %u\n", ::WSAGetLastError());
-                }
+        auto [it, isInserted] = m_connections.emplace(socket, Connection(socket, inet_ntoa(remoteAddr.sin_addr)));
+        printf("Accepted new connection from %s:%u\n",
+            inet_ntoa(remoteAddr.sin_addr), ntohs(remoteAddr.sin_port));
 
-                Log::Get().PrintInColor(Log::Color::kMagenta, "Connection lost.\n");
-                closesocket(conn.socket);
-                FD_CLR(conn.socket, &m_socketFDs);
-                m_connections.erase(m_connections.begin() + i);
-                continue;
-            }
+        OnConnectionEstablished(it->second);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Try to send everything queued since the last flush. Whatever doesn't fit waits for a writable event
+//--------------------------------------------------------------------------------------------------------------
+void NetworkServer::FlushConnections()
+{
+    for (SOCKET socket : m_dirtySockets)
+    {
+        auto it = m_connections.find(socket);
+        if (it == m_connections.end())
+            continue;
+
+        if (!it->second.Send())
+        {
+            Log::Get().PrintInColor(Log::Color::kMagenta, "Connection lost.\n");
+            CloseConnection(socket);
+            continue;
         }
+        m_pPoller->SetWriteInterest(socket, it->second.HasOutgoing());
+    }
+    m_dirtySockets.clear();
+}
+
+void NetworkServer::CloseConnection(SOCKET socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end())
+        return;
 
-        ++i;
+    // The seat is free for the next one to connect
+    if (socket == m_clientSocket)
+    {
+        m_clientSocket = INVALID_SOCKET;
+        m_isClientJoining = false;
     }
+
+    m_pPoller->Remove(socket);
+    it->second.Close();
+    m_connections.erase(it);
 }
 
 //--------------------------------------------------------------------------------------------------------------
@@ -204,75 +276,55 @@ void NetworkServer::GameUpdate(bool gameRunning)
     if (!gameRunning)
         m_active = false;
 
-    while (gameRunning)
+    // Let the client know the game is over, it may have been called early from the tablebase
+    if (!gameRunning && !m_isWinnerSent && m_pApp->GetWinner() != CheckersColor::kContinue)
     {
-        char message[kLimit];
+        Send(WinnerMessage((size_t)m_pApp->GetWinner()));
+        m_isWinnerSent = true;
+    }
+
+    // Whether the board changed this update, the client checks its hash against ours afterwards
+    bool isBoardChanged = false;
 
-        Message* msg = GetNextMessage();
-        if (!msg)
+    while (gameRunning)
+    {
+        AnyMessage message;
+        if (!m_hostMessages.empty())
         {
-            break;
+            message = m_hostMessages.front();
+            m_hostMessages.pop_front();
         }
-
-        // Remove
-        if (msg->type == Message::Type::Kill)
+        else if (!GetNextMessage(message))
         {
-            auto* pKill = static_cast<KillMessage*>(msg);
-
-            // Kill command sent by host/myself
-            if (pKill->m_isHostCalling)
-            {
-                m_pApp->Remove(pKill->m_index);
-                sprintf_s(message, kKill.c_str(), RevertedIndex((int)pKill->m_index), pKill->m_isHostCalling);
-                Log::Get().PrintInColor(Log::Color::kLightGray, "REMOVED ");
-                Log::Get().PrintInColor(Log::Color::kLightGreen, "%zd\n", pKill->m_index);
-            }
-            // Kill command sent by the client
-            else
-            {
-                m_pApp->Remove(RevertedIndex((int)pKill->m_index));
-                sprintf_s(message, kKill.c_str(), pKill->m_index, pKill->m_isHostCalling);
-                Log::Get().PrintInColor(Log::Color::kLightGray, "REMOVED ");
-                Log::Get().PrintInColor(Log::Color::kLightGreen, "%zd\n", RevertedIndex((int)pKill->m_index));
-            }
-
-            SendToAll(message);
+            break;
         }
+        const Message* msg = &message.Get();
 
-        // Move
-        if (msg->type == Message::Type::Move)
+        // Play, only if it's legal for whoever sent it. It passes the turn
+        if (msg->type == Message::Type::Play)
         {
-            // Move for this server's application
-            auto* pMove = static_cast<MoveMessage*>(msg);
-
-            // We need to adjust the moving piece's coords by 
-            if (pMove->m_isHostCalling)
+            auto* pPlay = static_cast<const PlayMessage*>(msg);
+            if (PlayMove(*pPlay))
             {
-                m_pApp->Move(pMove->m_fromIndex, pMove->m_destIndex);
-                sprintf_s(message, kMove.c_str(), RevertedIndex((int)pMove->m_fromIndex), RevertedIndex((int)pMove->m_destIndex), pMove->m_isHostCalling);
-                Log::Get().PrintInColor(Log::Color::kLightGray, "MOVED ");
-                Log::Get().PrintInColor(Log::Color::kLightGreen, "%zd", pMove->m_fromIndex);
-                Log::Get().PrintInColor(Log::Color::kLightGray, " TO ");
-                Log::Get().PrintInColor(Log::Color::kLightGreen, "%zd\n", pMove->m_destIndex);
+                isBoardChanged = true;
             }
             else
             {
-                m_pApp->Move(RevertedIndex((int)pMove->m_fromIndex), RevertedIndex((int)pMove->m_destIndex));
-                sprintf_s(message, kMove.c_str(), pMove->m_fromIndex, pMove->m_destIndex, pMove->m_isHostCalling);
-                Log::Get().PrintInColor(Log::Color::kLightGray, "MOVED ");
-                Log::Get().PrintInColor(Log::Color::kLightGreen, "%zd", RevertedIndex((int)pMove->m_fromIndex));
-                Log::Get().PrintInColor(Log::Color::kLightGray, " TO ");
-                Log::Get().PrintInColor(Log::Color::kLightGreen, "%zd\n", RevertedIndex((int)pMove->m_destIndex));
+                Log::Get().PrintInColor(Log::Color::kMagenta, "Rejected illegal move from the %s.\n", pPlay->m_isHostCalling ? "host" : "client");
+
+                // The client's board is off from ours, put it back
+                if (!pPlay->m_isHostCalling)
+                    Send(SnapshotMessage(m_pApp->GetPosition(), m_pApp->GetMoveCount(), m_pApp->GetHash()));
             }
 
-            SendToAll(message);
+            m_active = (m_pApp->GetPosition().m_sideToMove == CheckersColor::kDark);
+            m_logTurn = true;
         }
 
-        // Active
-        if (msg->type == Message::Type::Active)
+        // A client connected, it gets the whole game in one message
+        if (msg->type == Message::Type::Join)
         {
-            m_active = true;
-            m_logTurn = true;
+            Send(SnapshotMessage(m_pApp->GetPosition(), m_pApp->GetMoveCount(), m_pApp->GetHash()));
         }
 
         // Restart
@@ -280,38 +332,33 @@ void NetworkServer::GameUpdate(bool gameRunning)
         {
             m_pApp->Restart();
             Log::Get().PrintInColor(Log::Color::kLightCyan, "Game Restarted\n");
-            sprintf_s(message, kRestart.c_str());
-            SendToAll(message);
+            Send(RestartMessage());
+            m_active = (m_pApp->GetPosition().m_sideToMove == CheckersColor::kDark);
+            m_logTurn = true;
+            isBoardChanged = true;
         }
-
-        delete msg;
-        msg = nullptr;
     }
+
+    if (isBoardChanged)
+        SendHash();
 }
 
 //--------------------------------------------------------------------------------------------------------------
-// Add the message to our incoming messages if it's reasonable
+// Play message's move if it's one of the legal moves of the sender, then send it on whole.
+// Returns false if it isn't legal, or it isn't the sender's turn
 //--------------------------------------------------------------------------------------------------------------
-void NetworkServer::OnMessage(const std::string& message)
+bool NetworkServer::PlayMove(const PlayMessage& message)
 {
-    size_t fromIndex = kInvalidIndex;
-    size_t destIndex = kInvalidIndex;
-    size_t isHostCalling = 0;
-
-    if (2 == sscanf_s(message.c_str(), (--kKill).c_str(), &destIndex, &isHostCalling))
-        m_incomingMessages.emplace(new KillMessage(destIndex, isHostCalling));
-
-    else if (3 == sscanf_s(message.c_str(), (--kMove).c_str(), &fromIndex, &destIndex, &isHostCalling))
-        m_incomingMessages.emplace(new MoveMessage(fromIndex, destIndex, isHostCalling));
-
-    else if (message.compare(--kActive) == 0)
-        m_incomingMessages.emplace(new ActiveMessage());
-
-    else if (message.compare(kRestart) == 0)
-        m_incomingMessages.emplace(new RestartMessage());
-
-    else
-        Log::Get().PrintInColor(Log::Color::kMagenta, "Unhandled message.\n");
+    CheckersColor side = message.m_isHostCalling ? CheckersColor::kDark : CheckersColor::kLight;
+    const Position& position = m_pApp->GetPosition();
+    if (position.m_sideToMove != side || !IsLegalMove(position, message.m_move))
+        return false;
+
+    m_pApp->PlayMove(message.m_move);
+    Send(message);
+    Log::Get().PrintInColor(Log::Color::kLightGray, "PLAYED ");
+    Log::Get().PrintInColor(Log::Color::kLightGreen, "%s\n", MoveToString(message.m_move).c_str());
+    return true;
 }
 
 //--------------------------------------------------------------------------------------------------------------
@@ -320,46 +367,58 @@ void NetworkServer::OnMessage(const std::string& message)
 //--------------------------------------------------------------------------------------------------------------
 void NetworkServer::OnConnectionEstablished(Connection& conn)
 {
-    // If connection is more than one, pop the extras with Game is Full message to that connection.
-    if (m_connections.size() > 1)
+    // If a client is already playing, pop the extras with Game is Full message to that connection.
+    if (m_clientSocket != INVALID_SOCKET)
     {
-        conn.outgoingBuffer.insert(conn.outgoingBuffer.end(), kGameFull.begin(), kGameFull.end());
+        SendTo(conn, GameFullMessage());
     }
-    // If this is the only connection, send the checkers board data to it, and the current turn
+    // Otherwise this one plays, ask the game for its board. Until it comes the connection gets nothing,
+    // the board has everything sent before it
     else
     {
-        char message[kLimit];
-        std::string msg;
-        AllPiecesIndex allPiecesIndex = m_pApp->GetAllPiecesIndex();
-
-        // All opponent/host/dark pieces from client/light POV
-        for (size_t index : allPiecesIndex[(size_t)CheckersColor::kDark])
-        {
-            sprintf_s(message, kPiece.c_str(), (size_t)CheckersColor::kDark, RevertedIndex((int)index));
-            msg = message;
-            conn.outgoingBuffer.insert(conn.outgoingBuffer.end(), msg.begin(), msg.end());
-        }
-
-        // All ally/client/light pieces from client/light POV
-        for (size_t index : allPiecesIndex[(size_t)CheckersColor::kLight])
-        {
-            sprintf_s(message, kPiece.c_str(), (size_t)CheckersColor::kLight, RevertedIndex((int)index));
-            msg = message;
-            conn.outgoingBuffer.insert(conn.outgoingBuffer.end(), msg.begin(), msg.end());
-        }
-
-        // Turn
-        sprintf_s(message, kTurn.c_str(), !m_active);
-        msg = message;
-        conn.outgoingBuffer.insert(conn.outgoingBuffer.end(), msg.begin(), msg.end());
+        m_clientSocket = conn.GetSocket();
+        m_isClientJoining = true;
+        OnMessage(JoinMessage(0));
     }
 }
 
-void NetworkServer::SendToAll(const std::string& message)
+//--------------------------------------------------------------------------------------------------------------
+// Send our position hash to everyone, so clients can tell if they drifted from the host's board
+//--------------------------------------------------------------------------------------------------------------
+void NetworkServer::SendHash()
+{
+    Send(HashMessage(m_pApp->GetHash()));
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Network thread. Everything the game sent since the last pass, the board lets a joining client in
+//--------------------------------------------------------------------------------------------------------------
+void NetworkServer::SendQueuedMessages()
 {
-    for (auto& conn : m_connections)
+    AnyMessage message;
+    while (m_outgoingMessages.Pop(message))
     {
-        conn.outgoingBuffer.insert(conn.outgoingBuffer.end(),
-            message.begin(), message.end());
+        if (message.GetType() == Message::Type::Snapshot)
+            m_isClientJoining = false;
+        SendToClient(message.Get());
     }
+}
+
+// Extra connections only ever get GAME IS FULL
+void NetworkServer::SendToClient(const Message& message)
+{
+    auto it = m_connections.find(m_clientSocket);
+    if (it != m_connections.end() && !m_isClientJoining)
+        SendTo(it->second, message);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Queue message for conn, it goes out at the end of this update
+//--------------------------------------------------------------------------------------------------------------
+void NetworkServer::SendTo(Connection& conn, const Message& message)
+{
+    if (!conn.HasOutgoing())
+        m_dirtySockets.emplace_back(conn.GetSocket());
+    if (!conn.Queue(message))
+        m_dirtySockets.emplace_back(conn.GetSocket());  // Its Send fails on the flush, which closes it
 }
\ No newline at end of file
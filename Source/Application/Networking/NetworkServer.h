@@ -1,38 +1,48 @@
 #pragma once
 
 #include "Network.h"
+#include "Connection.h"
+
+#include <unordered_map>
 
 //--------------------------------------------------------------------------------------------------------------
 // The host is authoritative over the game state and is the one listening for connections.
-// Also the dark piece player
+// Also the dark piece player. The connections live on the network thread, the game state on the game's
 //--------------------------------------------------------------------------------------------------------------
 class NetworkServer final : public NetworkingBase
 {
 private:
-    struct Connection
-    {
-        SOCKET socket;
-        std::string nickname;
-        std::vector<char> incomingBuffer;
-        std::vector<char> outgoingBuffer;
-    };
+    // Game thread
+    std::deque<AnyMessage> m_hostMessages;  // Our own input, played with the client's in the game update
+    bool m_isWinnerSent;
 
-    // Connections
+    // Network thread
     SOCKET m_listener;
-    fd_set m_socketFDs;
-    std::vector<Connection> m_connections;
+    std::unordered_map<SOCKET, Connection> m_connections;
+    std::vector<SOCKET> m_dirtySockets;     // Connections that queued output since the last flush
+    std::vector<SOCKET> m_backlogSockets;   // Connections that used their message budget with bytes still unread
+    std::vector<SOCKET> m_readySockets;     // Last update's backlog, being read now
+    SOCKET m_clientSocket;                  // The one client playing light, INVALID_SOCKET until it connects
+    bool m_isClientJoining;                 // Its board hasn't been sent yet
 
 public:
     NetworkServer(App* _pApp);
     virtual void Initialize() override;
     virtual void Shutdown() override;
     virtual void Update(bool gameRunning) override;
-    virtual void HandleInput(const std::string& instruction) override;
+    virtual void HandleInput(const Message& instruction) override;
 
 private:
-    virtual void OnMessage(const std::string& message) override;
     virtual void WinsockUpdate() override;
     virtual void GameUpdate(bool gameRunning) override;
-    void SendToAll(const std::string& message);
+    bool PlayMove(const PlayMessage& message);
+    void SendToClient(const Message& message);
+    void SendTo(Connection& conn, const Message& message);
+    void SendHash();
+    void SendQueuedMessages();
+    void ReadMessages(Connection& conn);
+    void AcceptConnections();
+    void FlushConnections();
+    void CloseConnection(SOCKET socket);
     void OnConnectionEstablished(Connection& conn);
 };
\ No newline at end of file
@@ -0,0 +1,17 @@
+#include "Poller.h"
+
+#include "EpollPoller.h"
+#include "SelectPoller.h"
+
+//--------------------------------------------------------------------------------------------------------------
+// Falls back to select if the kernel won't give us an epoll instance
+//--------------------------------------------------------------------------------------------------------------
+std::unique_ptr<Poller> Poller::Create()
+{
+#ifdef __linux__
+    std::unique_ptr<EpollPoller> pEpoll = std::make_unique<EpollPoller>();
+    if (pEpoll->IsValid())
+        return pEpoll;
+#endif
+    return std::make_unique<SelectPoller>();
+}
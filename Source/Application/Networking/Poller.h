@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Socket.h"
+
+#include <memory>
+
+//--------------------------------------------------------------------------------------------------------------
+// What a socket is ready for
+//--------------------------------------------------------------------------------------------------------------
+struct PollEvent
+{
+    SOCKET m_socket = INVALID_SOCKET;
+    bool m_isReadable = false;      // Also set when the peer hung up, the read then returns 0
+    bool m_isWritable = false;
+    bool m_isError = false;         // Broken or refused, GetPendingError says why
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Waits on many sockets at once and reports only the ones that are ready.
+// Readiness may be edge-triggered, so users must keep to these rules on every backend:
+//  - On a readable event, read until the socket would block
+//  - After queueing output, try to send right away. Only ask for writable events while output is left over
+//--------------------------------------------------------------------------------------------------------------
+class Poller
+{
+public:
+    virtual ~Poller() = default;
+
+    // Start watching socket for reads, and for writes while SetWriteInterest says so
+    virtual bool Add(SOCKET socket) = 0;
+    virtual void Remove(SOCKET socket) = 0;
+    virtual void SetWriteInterest(SOCKET socket, bool isInterested) = 0;
+
+    // Block up to timeoutMs for at least one ready socket, fill pEvents and return how many there are
+    virtual size_t Wait(PollEvent* pEvents, size_t maxEvents, int timeoutMs) = 0;
+
+    // The best backend for this platform: edge-triggered epoll on Linux, select anywhere else
+    static std::unique_ptr<Poller> Create();
+};
@@ -0,0 +1,472 @@
+#include "Protocol.h"
+
+#include "Checkers/CheckersConstants.h"
+
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+
+//--------------------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------------------
+static void WriteU64(uint64_t value, std::vector<char>& buffer)
+{
+    for (size_t i = 0; i < sizeof(value); ++i)
+        buffer.emplace_back((char)((value >> (i * 8)) & 0xFF));
+}
+
+static void WriteU32(uint32_t value, std::vector<char>& buffer)
+{
+    for (size_t i = 0; i < sizeof(value); ++i)
+        buffer.emplace_back((char)((value >> (i * 8)) & 0xFF));
+}
+
+static uint32_t ReadU32(const uint8_t* pBytes)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < sizeof(value); ++i)
+        value |= (uint32_t)pBytes[i] << (i * 8);
+    return value;
+}
+
+static uint64_t ReadU64(const uint8_t* pBytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(value); ++i)
+        value |= (uint64_t)pBytes[i] << (i * 8);
+    return value;
+}
+
+// 7 bits at a time, low ones first, the top bit says more follow. Small values take one byte
+static void WriteVarint(uint64_t value, std::vector<char>& buffer)
+{
+    while (value >= 0x80)
+    {
+        buffer.emplace_back((char)((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.emplace_back((char)value);
+}
+
+// Returns how many bytes it took, 0 if size runs out first or it's longer than any we write
+static size_t ReadVarint(const uint8_t* pBytes, size_t size, uint64_t& value)
+{
+    value = 0;
+    for (size_t i = 0; i < size && i < 10; ++i)
+    {
+        value |= (uint64_t)(pBytes[i] & 0x7F) << (i * 7);
+        if ((pBytes[i] & 0x80) == 0)
+            return i + 1;
+    }
+    return 0;
+}
+
+// Frame header, the payload is appended after it
+static void WriteHeader(Opcode opcode, size_t payloadSize, std::vector<char>& buffer)
+{
+    buffer.emplace_back((char)(1 + payloadSize));
+    buffer.emplace_back((char)opcode);
+}
+
+static bool IsSide(size_t side)
+{
+    return side < (size_t)CheckersColor::kCount;
+}
+
+static bool IsFlag(size_t value)
+{
+    return value == 0 || value == 1;
+}
+
+// Nobody shares a square, and only occupied squares hold kings
+static bool IsPosition(Bitboard dark, Bitboard light, Bitboard kings)
+{
+    return (dark & light) == 0 && (kings & ~(dark | light)) == 0;
+}
+
+// Squares on the board, a step or one hop per captured piece
+static bool IsMoveShape(const Move& move)
+{
+    if (move.m_pathLength < 2 || move.m_pathLength > kMaxCaptures + 1)
+        return false;
+
+    for (size_t i = 0; i < move.m_pathLength; ++i)
+    {
+        if (move.m_path[i] >= kSquareCount)
+            return false;
+    }
+
+    return move.m_captured ? (size_t)std::popcount(move.m_captured) == move.m_pathLength - 1u : move.m_pathLength == 2;
+}
+
+// Fill move's captures from its path, each hop two diagonals away jumps the square between.
+// Returns false if a path longer than one step has a hop that isn't a jump, or a square is off the board
+static bool ReadCaptures(Move& move)
+{
+    move.m_captured = 0;
+    for (size_t i = 1; i < move.m_pathLength; ++i)
+    {
+        size_t from = move.m_path[i - 1];
+        if (from >= kSquareCount)
+            return false;
+
+        bool isJump = false;
+        for (size_t dir = 0; dir < (size_t)Direction::kCount && !isJump; ++dir)
+        {
+            if (kJumpSquare[from][dir] == move.m_path[i])
+            {
+                move.m_captured |= GetSquareMask(kNeighborSquare[from][dir]);
+                isJump = true;
+            }
+        }
+
+        if (!isJump && move.m_pathLength > 2)
+            return false;
+    }
+    return true;
+}
+
+// "22-18-11", the squares the piece stands on
+static void WritePath(const Move& move, char* pText, size_t size)
+{
+    size_t length = 0;
+    for (size_t i = 0; i < move.m_pathLength && length < size; ++i)
+        length += snprintf(pText + length, size - length, (i == 0) ? "%u" : "-%u", (unsigned int)move.m_path[i]);
+}
+
+static bool ReadPath(const char* pText, Move& move)
+{
+    move.m_pathLength = 0;
+    while (true)
+    {
+        char* pEnd = nullptr;
+        unsigned long square = strtoul(pText, &pEnd, 10);
+        if (pEnd == pText || square >= kSquareCount || move.m_pathLength > kMaxCaptures)
+            return false;
+
+        move.m_path[move.m_pathLength++] = (uint8_t)square;
+        if (*pEnd == '\0')
+            return true;
+        if (*pEnd != '-')
+            return false;
+        pText = pEnd + 1;
+    }
+}
+
+static Position MakePosition(Bitboard dark, Bitboard light, Bitboard kings, size_t sideToMove)
+{
+    Position position;
+    position.m_pieces[(size_t)CheckersColor::kDark] = dark;
+    position.m_pieces[(size_t)CheckersColor::kLight] = light;
+    position.m_kings = kings;
+    position.m_sideToMove = (CheckersColor)sideToMove;
+    return position;
+}
+
+// Formats without their '\n', made once instead of for every line read
+static const std::string kPlayLine = --kPlay;
+static const std::string kGameFullLine = --kGameFull;
+static const std::string kTurnLine = --kTurn;
+static const std::string kRestartLine = --kRestart;
+static const std::string kWinnerLine = --kWinner;
+static const std::string kHashLine = --kHash;
+static const std::string kSeatLine = --kSeat;
+static const std::string kJoinLine = --kJoin;
+static const std::string kSnapshotLine = --kSnapshot;
+static const std::string kResumeLine = --kResume;
+static const std::string kWatchLine = --kWatch;
+
+static bool Decoded(const Message& decoded, AnyMessage& message)
+{
+    message.Set(decoded);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Same lines the game always sent, so peers without binary still understand them
+//--------------------------------------------------------------------------------------------------------------
+void EncodeText(const Message& message, std::vector<char>& buffer)
+{
+    char line[kLimit];
+    line[0] = '\0';
+
+    switch (message.type)
+    {
+    case Message::Type::Play:
+    {
+        auto& play = static_cast<const PlayMessage&>(message);
+        char path[kLimit];
+        WritePath(play.m_move, path, sizeof(path));
+        sprintf_s(line, kPlay.c_str(), play.m_isHostCalling, play.m_sequence, play.m_move.m_captured, path);
+        break;
+    }
+    case Message::Type::GameFull:
+        sprintf_s(line, kGameFull.c_str());
+        break;
+    case Message::Type::Turn:
+        sprintf_s(line, kTurn.c_str(), static_cast<const TurnMessage&>(message).m_side);
+        break;
+    case Message::Type::Restart:
+        sprintf_s(line, kRestart.c_str(), static_cast<const RestartMessage&>(message).m_sequence);
+        break;
+    case Message::Type::Hash:
+        sprintf_s(line, kHash.c_str(), static_cast<const HashMessage&>(message).m_hash);
+        break;
+    case Message::Type::Winner:
+        sprintf_s(line, kWinner.c_str(), static_cast<const WinnerMessage&>(message).m_side);
+        break;
+    case Message::Type::Seat:
+    {
+        auto& seat = static_cast<const SeatMessage&>(message);
+        sprintf_s(line, kSeat.c_str(), seat.m_side, seat.m_token);
+        break;
+    }
+    case Message::Type::Join:
+        sprintf_s(line, kJoin.c_str(), static_cast<const JoinMessage&>(message).m_sessionId);
+        break;
+    case Message::Type::Snapshot:
+    {
+        auto& snapshot = static_cast<const SnapshotMessage&>(message);
+        const Position& position = snapshot.m_position;
+        sprintf_s(line, kSnapshot.c_str(), position.m_pieces[(size_t)CheckersColor::kDark], position.m_pieces[(size_t)CheckersColor::kLight],
+            position.m_kings, (size_t)position.m_sideToMove, snapshot.m_moveCount, snapshot.m_hash, snapshot.m_sequence);
+        break;
+    }
+    case Message::Type::Resume:
+    {
+        auto& resume = static_cast<const ResumeMessage&>(message);
+        sprintf_s(line, kResume.c_str(), resume.m_sessionId, resume.m_side, resume.m_sequence, resume.m_token);
+        break;
+    }
+    case Message::Type::Watch:
+        sprintf_s(line, kWatch.c_str(), static_cast<const WatchMessage&>(message).m_sessionId);
+        break;
+    default:
+        assert(false);
+        return;
+    }
+
+    buffer.insert(buffer.end(), line, line + strlen(line));
+}
+
+void EncodeBinary(const Message& message, std::vector<char>& buffer)
+{
+    switch (message.type)
+    {
+    case Message::Type::Play:
+    {
+        auto& play = static_cast<const PlayMessage&>(message);
+        size_t headerOffset = buffer.size();
+        WriteHeader(Opcode::kPlay, 0, buffer);
+        WriteVarint(((uint64_t)play.m_sequence << 1) | play.m_isHostCalling, buffer);
+        buffer.insert(buffer.end(), play.m_move.m_path, play.m_move.m_path + play.m_move.m_pathLength);
+        buffer[headerOffset] = (char)(buffer.size() - headerOffset - 1);
+        break;
+    }
+    case Message::Type::GameFull:
+        WriteHeader(Opcode::kGameFull, 0, buffer);
+        break;
+    case Message::Type::Turn:
+        WriteHeader(Opcode::kTurn, 1, buffer);
+        buffer.emplace_back((char)static_cast<const TurnMessage&>(message).m_side);
+        break;
+    case Message::Type::Restart:
+        WriteHeader(Opcode::kRestart, 4, buffer);
+        WriteU32((uint32_t)static_cast<const RestartMessage&>(message).m_sequence, buffer);
+        break;
+    case Message::Type::Hash:
+        WriteHeader(Opcode::kHash, 8, buffer);
+        WriteU64(static_cast<const HashMessage&>(message).m_hash, buffer);
+        break;
+    case Message::Type::Winner:
+        WriteHeader(Opcode::kWinner, 1, buffer);
+        buffer.emplace_back((char)static_cast<const WinnerMessage&>(message).m_side);
+        break;
+    case Message::Type::Seat:
+    {
+        auto& seat = static_cast<const SeatMessage&>(message);
+        WriteHeader(Opcode::kSeat, 9, buffer);
+        buffer.emplace_back((char)seat.m_side);
+        WriteU64(seat.m_token, buffer);
+        break;
+    }
+    case Message::Type::Join:
+        WriteHeader(Opcode::kJoin, 8, buffer);
+        WriteU64(static_cast<const JoinMessage&>(message).m_sessionId, buffer);
+        break;
+    case Message::Type::Snapshot:
+    {
+        auto& snapshot = static_cast<const SnapshotMessage&>(message);
+        const Position& position = snapshot.m_position;
+        WriteHeader(Opcode::kSnapshot, 29, buffer);
+        WriteU32(position.m_pieces[(size_t)CheckersColor::kDark], buffer);
+        WriteU32(position.m_pieces[(size_t)CheckersColor::kLight], buffer);
+        WriteU32(position.m_kings, buffer);
+        buffer.emplace_back((char)position.m_sideToMove);
+        WriteU32((uint32_t)snapshot.m_moveCount, buffer);
+        WriteU64(snapshot.m_hash, buffer);
+        WriteU32((uint32_t)snapshot.m_sequence, buffer);
+        break;
+    }
+    case Message::Type::Resume:
+    {
+        auto& resume = static_cast<const ResumeMessage&>(message);
+        WriteHeader(Opcode::kResume, 21, buffer);
+        WriteU64(resume.m_sessionId, buffer);
+        buffer.emplace_back((char)resume.m_side);
+        WriteU32((uint32_t)resume.m_sequence, buffer);
+        WriteU64(resume.m_token, buffer);
+        break;
+    }
+    case Message::Type::Watch:
+        WriteHeader(Opcode::kWatch, 8, buffer);
+        WriteU64(static_cast<const WatchMessage&>(message).m_sessionId, buffer);
+        break;
+    default:
+        assert(false);
+        break;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Try every format in turn, the fallback for peers that don't speak binary
+//--------------------------------------------------------------------------------------------------------------
+bool DecodeText(const char* pLine, size_t length, AnyMessage& message)
+{
+    if (length >= kLimit)
+        return false;
+
+    char line[kLimit];
+    memcpy(line, pLine, length);
+    line[length] = '\0';
+
+    size_t side = kInvalidIndex;
+    size_t isHostCalling = 0;
+    size_t sessionId = kInvalidIndex;
+    unsigned long long hash = 0;
+    unsigned long long token = 0;
+    Bitboard dark = 0;
+    Bitboard light = 0;
+    Bitboard kings = 0;
+    size_t moveCount = 0;
+    size_t sequence = 0;
+    char path[kLimit];
+    Move move;
+
+    if (4 == sscanf_s(line, kPlayLine.c_str(), &isHostCalling, &sequence, &move.m_captured, path, (unsigned int)sizeof(path))
+        && IsFlag(isHostCalling) && ReadPath(path, move) && IsMoveShape(move))
+        return Decoded(PlayMessage(move, isHostCalling, sequence), message);
+
+    if (strcmp(line, kGameFullLine.c_str()) == 0)
+        return Decoded(GameFullMessage(), message);
+
+    if (1 == sscanf_s(line, kTurnLine.c_str(), &side) && IsSide(side))
+        return Decoded(TurnMessage(side), message);
+
+    if (1 == sscanf_s(line, kRestartLine.c_str(), &sequence))
+        return Decoded(RestartMessage(sequence), message);
+
+    if (1 == sscanf_s(line, kWinnerLine.c_str(), &side) && IsSide(side))
+        return Decoded(WinnerMessage(side), message);
+
+    if (1 == sscanf_s(line, kHashLine.c_str(), &hash))
+        return Decoded(HashMessage(hash), message);
+
+    if (2 == sscanf_s(line, kSeatLine.c_str(), &side, &token) && IsSide(side))
+        return Decoded(SeatMessage(side, token), message);
+
+    if (1 == sscanf_s(line, kJoinLine.c_str(), &sessionId))
+        return Decoded(JoinMessage(sessionId), message);
+
+    if (7 == sscanf_s(line, kSnapshotLine.c_str(), &dark, &light, &kings, &side, &moveCount, &hash, &sequence)
+        && IsSide(side) && IsPosition(dark, light, kings))
+        return Decoded(SnapshotMessage(MakePosition(dark, light, kings, side), moveCount, hash, sequence), message);
+
+    if (4 == sscanf_s(line, kResumeLine.c_str(), &sessionId, &side, &sequence, &token) && IsSide(side))
+        return Decoded(ResumeMessage(sessionId, side, sequence, token), message);
+
+    if (1 == sscanf_s(line, kWatchLine.c_str(), &sessionId))
+        return Decoded(WatchMessage(sessionId), message);
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Read the fields straight out of the frame, a size that doesn't match the opcode makes it unknown
+//--------------------------------------------------------------------------------------------------------------
+bool DecodeBinary(const uint8_t* pFrame, size_t length, AnyMessage& message)
+{
+    if (length == 0)
+        return false;
+
+    const uint8_t* pPayload = pFrame + 1;
+    size_t payloadSize = length - 1;
+
+    switch ((Opcode)pFrame[0])
+    {
+    case Opcode::kPlay:
+    {
+        uint64_t sequenceAndFlag = 0;
+        size_t varintSize = ReadVarint(pPayload, payloadSize, sequenceAndFlag);
+        if (varintSize == 0 || payloadSize - varintSize > kMaxCaptures + 1)
+            break;
+
+        // The captures aren't sent, the path says which pieces were jumped
+        Move move;
+        move.m_pathLength = (uint8_t)(payloadSize - varintSize);
+        memcpy(move.m_path, pPayload + varintSize, move.m_pathLength);
+        if (ReadCaptures(move) && IsMoveShape(move))
+            return Decoded(PlayMessage(move, (size_t)(sequenceAndFlag & 1), (size_t)(sequenceAndFlag >> 1)), message);
+        break;
+    }
+    case Opcode::kGameFull:
+        if (payloadSize == 0)
+            return Decoded(GameFullMessage(), message);
+        break;
+    case Opcode::kTurn:
+        if (payloadSize == 1 && IsSide(pPayload[0]))
+            return Decoded(TurnMessage(pPayload[0]), message);
+        break;
+    case Opcode::kRestart:
+        if (payloadSize == 4)
+            return Decoded(RestartMessage(ReadU32(pPayload)), message);
+        break;
+    case Opcode::kHash:
+        if (payloadSize == 8)
+            return Decoded(HashMessage(ReadU64(pPayload)), message);
+        break;
+    case Opcode::kWinner:
+        if (payloadSize == 1 && IsSide(pPayload[0]))
+            return Decoded(WinnerMessage(pPayload[0]), message);
+        break;
+    case Opcode::kSeat:
+        if (payloadSize == 9 && IsSide(pPayload[0]))
+            return Decoded(SeatMessage(pPayload[0], ReadU64(pPayload + 1)), message);
+        break;
+    case Opcode::kJoin:
+        if (payloadSize == 8)
+            return Decoded(JoinMessage((size_t)ReadU64(pPayload)), message);
+        break;
+    case Opcode::kSnapshot:
+    {
+        if (payloadSize != 29)
+            break;
+
+        Bitboard dark = ReadU32(pPayload);
+        Bitboard light = ReadU32(pPayload + 4);
+        Bitboard kings = ReadU32(pPayload + 8);
+        if (IsSide(pPayload[12]) && IsPosition(dark, light, kings))
+            return Decoded(SnapshotMessage(MakePosition(dark, light, kings, pPayload[12]), ReadU32(pPayload + 13), ReadU64(pPayload + 17), ReadU32(pPayload + 25)), message);
+        break;
+    }
+    case Opcode::kResume:
+        if (payloadSize == 21 && IsSide(pPayload[8]))
+            return Decoded(ResumeMessage((size_t)ReadU64(pPayload), pPayload[8], ReadU32(pPayload + 9), ReadU64(pPayload + 13)), message);
+        break;
+    case Opcode::kWatch:
+        if (payloadSize == 8)
+            return Decoded(WatchMessage((size_t)ReadU64(pPayload)), message);
+        break;
+    }
+    return false;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Network.h"
+
+#include <cstdint>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------------------
+// Wire format of messages.
+// Text: one line per message, see the formats in CheckersConstants.h. Every peer speaks it.
+// Binary: a frame per message, [length][opcode][payload], length counts the opcode and payload bytes.
+//         Tile indices, squares and sides take one byte, bitboards, move counts and sequences four, hashes and
+//         session ids eight, all in little endian.
+// A connection starts in text. The client offers binary with HELLO, a server that knows it answers with BINARY
+// and writes frames from then on, and the client does the same once it reads that BINARY
+//--------------------------------------------------------------------------------------------------------------
+static constexpr size_t kProtocolVersion = 5;       // Binary version, bumped when a frame's layout changes
+static constexpr size_t kMaxFrameSize = 256;        // Length byte included
+
+enum class Opcode : uint8_t
+{
+    // 1, 2 and 4 were KILL, MOVE and ACTIVE until PLAY replaced them, they aren't reused
+    kGameFull = 3,
+    kTurn = 6,          // side
+    kRestart = 7,       // sequence
+    kHash = 8,          // hash
+    kWinner = 9,        // side
+    kSeat = 10,         // side, resume token
+    kJoin = 11,         // sessionId
+    kSnapshot = 12,     // dark, light, kings, sideToMove, moveCount, hash, sequence
+    kPlay = 13,         // varint of sequence << 1 | isHostCalling, squares of the path, as many as the frame holds.
+                        // Captures aren't sent, every hop of the path jumps the square between
+    kResume = 14,       // sessionId, side, sequence, resume token
+    kWatch = 15,        // sessionId
+};
+
+// Append message to buffer, as a line or as a frame
+void EncodeText(const Message& message, std::vector<char>& buffer);
+void EncodeBinary(const Message& message, std::vector<char>& buffer);
+
+// Read message from a line without its '\n', or a frame without its length byte. Returns false if it's not one we know
+bool DecodeText(const char* pLine, size_t length, AnyMessage& message);
+bool DecodeBinary(const uint8_t* pFrame, size_t length, AnyMessage& message);
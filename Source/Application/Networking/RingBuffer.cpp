@@ -0,0 +1,111 @@
+#include "RingBuffer.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+RingBuffer::RingBuffer(size_t capacity)
+    : m_data{}
+    , m_readIndex{ 0 }
+    , m_size{ 0 }
+{
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    m_data.resize(capacity);
+}
+
+const char* RingBuffer::GetReadRegion(size_t& size, size_t offset) const
+{
+    assert(offset <= m_size);
+    size_t startIndex = (m_readIndex + offset) & (m_data.size() - 1);
+    size = (std::min)(m_size - offset, m_data.size() - startIndex);
+    return m_data.data() + startIndex;
+}
+
+void RingBuffer::Consume(size_t size)
+{
+    assert(size <= m_size);
+    m_size -= size;
+
+    // Empty, start over at the beginning so the next regions are as long as they can be
+    m_readIndex = (m_size == 0) ? 0 : (m_readIndex + size) & (m_data.size() - 1);
+}
+
+char* RingBuffer::GetWriteRegion(size_t& size)
+{
+    size_t writeIndex = (m_readIndex + m_size) & (m_data.size() - 1);
+    size = (writeIndex < m_readIndex || m_size == m_data.size()) ? GetFreeSize() : m_data.size() - writeIndex;
+    return m_data.data() + writeIndex;
+}
+
+void RingBuffer::Commit(size_t size)
+{
+    assert(size <= GetFreeSize());
+    m_size += size;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Append size bytes, doubling the block first if they don't fit
+//--------------------------------------------------------------------------------------------------------------
+void RingBuffer::Write(const char* pBytes, size_t size)
+{
+    if (size > GetFreeSize())
+        Reserve(m_size + size);
+
+    while (size > 0)
+    {
+        size_t regionSize = 0;
+        char* pRegion = GetWriteRegion(regionSize);
+        size_t copySize = (std::min)(regionSize, size);
+
+        memcpy(pRegion, pBytes, copySize);
+        Commit(copySize);
+        pBytes += copySize;
+        size -= copySize;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Grow to the next power of two holding capacity bytes, the used bytes move to the front of the new block
+//--------------------------------------------------------------------------------------------------------------
+void RingBuffer::Reserve(size_t capacity)
+{
+    if (capacity <= m_data.size())
+        return;
+
+    size_t newCapacity = m_data.size();
+    while (newCapacity < capacity)
+        newCapacity *= 2;
+
+    std::vector<char> data(newCapacity);
+    Peek(0, data.data(), m_size);
+    m_data.swap(data);
+    m_readIndex = 0;
+}
+
+void RingBuffer::Peek(size_t offset, char* pOut, size_t size) const
+{
+    assert(offset + size <= m_size);
+    if (size == 0)
+        return;
+
+    size_t startIndex = (m_readIndex + offset) & (m_data.size() - 1);
+    size_t firstSize = (std::min)(size, m_data.size() - startIndex);
+    memcpy(pOut, m_data.data() + startIndex, firstSize);
+    memcpy(pOut + firstSize, m_data.data(), size - firstSize);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Offset of the first byte equal to value, kNotFound if there's none
+//--------------------------------------------------------------------------------------------------------------
+size_t RingBuffer::Find(char value) const
+{
+    size_t firstSize = (std::min)(m_size, m_data.size() - m_readIndex);
+    const char* pFirst = m_data.data() + m_readIndex;
+    if (const void* pFound = memchr(pFirst, value, firstSize))
+        return static_cast<const char*>(pFound) - pFirst;
+
+    if (const void* pFound = memchr(m_data.data(), value, m_size - firstSize))
+        return firstSize + (static_cast<const char*>(pFound) - m_data.data());
+
+    return kNotFound;
+}
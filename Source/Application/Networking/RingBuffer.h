@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------------------
+// Byte queue over one block whose capacity is a power of two. Reading and writing only move an index, nothing is
+// shifted, and the free and used bytes are handed out as contiguous regions so recv and send work on them directly.
+// A write that doesn't fit doubles the block
+//--------------------------------------------------------------------------------------------------------------
+class RingBuffer
+{
+public:
+    static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+private:
+    std::vector<char> m_data;
+    size_t m_readIndex;     // First used byte
+    size_t m_size;          // Used bytes, they may wrap past the end of m_data
+
+public:
+    explicit RingBuffer(size_t capacity);
+
+    size_t GetSize() const { return m_size; }
+    size_t GetCapacity() const { return m_data.size(); }
+    size_t GetFreeSize() const { return m_data.size() - m_size; }
+    bool IsEmpty() const { return m_size == 0; }
+
+    // Used bytes from offset bytes past the front up to the end of the block, size tells how many
+    const char* GetReadRegion(size_t& size, size_t offset = 0) const;
+    void Consume(size_t size);
+
+    // Free bytes after the back up to the end of the block, Commit the ones that were filled
+    char* GetWriteRegion(size_t& size);
+    void Commit(size_t size);
+
+    void Write(const char* pBytes, size_t size);
+    void Reserve(size_t capacity);
+
+    // Copy size bytes starting offset bytes past the front, across the wrap if there is one
+    void Peek(size_t offset, char* pOut, size_t size) const;
+    char At(size_t offset) const { return m_data[(m_readIndex + offset) & (m_data.size() - 1)]; }
+    size_t Find(char value) const;
+};
@@ -0,0 +1,84 @@
+#include "SelectPoller.h"
+
+#include <algorithm>
+
+#ifndef _WIN32
+#include <sys/select.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------------------
+// Winsock's fd_set is a list capped at FD_SETSIZE sockets, elsewhere it's a bitmask that only holds descriptors
+// below FD_SETSIZE, however few are watched
+//--------------------------------------------------------------------------------------------------------------
+bool SelectPoller::Add(SOCKET socket)
+{
+    if (m_watches.size() >= FD_SETSIZE)
+        return false;
+#ifndef _WIN32
+    if (socket < 0 || socket >= FD_SETSIZE)
+        return false;
+#endif
+
+    m_watches.push_back({ socket, false });
+    return true;
+}
+
+void SelectPoller::Remove(SOCKET socket)
+{
+    m_watches.erase(std::remove_if(m_watches.begin(), m_watches.end(),
+        [socket](const Watch& watch) { return watch.m_socket == socket; }), m_watches.end());
+}
+
+void SelectPoller::SetWriteInterest(SOCKET socket, bool isInterested)
+{
+    for (Watch& watch : m_watches)
+    {
+        if (watch.m_socket == socket)
+            watch.m_isWriteInterested = isInterested;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Wait for any watched socket, returns how many events were filled
+//--------------------------------------------------------------------------------------------------------------
+size_t SelectPoller::Wait(PollEvent* pEvents, size_t maxEvents, int timeoutMs)
+{
+    fd_set reads, writes, excepts;
+    FD_ZERO(&reads);
+    FD_ZERO(&writes);
+    FD_ZERO(&excepts);
+
+    SOCKET highest = 0;
+    for (const Watch& watch : m_watches)
+    {
+        FD_SET(watch.m_socket, &reads);
+        FD_SET(watch.m_socket, &excepts);
+        if (watch.m_isWriteInterested)
+            FD_SET(watch.m_socket, &writes);
+        highest = (std::max)(highest, watch.m_socket);
+    }
+
+    timeval tv;
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+
+    // The first argument is ignored by Winsock
+    if (select((int)highest + 1, &reads, &writes, &excepts, (timeoutMs < 0) ? nullptr : &tv) <= 0)
+        return 0;
+
+    size_t count = 0;
+    for (const Watch& watch : m_watches)
+    {
+        if (count == maxEvents)
+            break;
+
+        PollEvent event;
+        event.m_socket = watch.m_socket;
+        event.m_isReadable = FD_ISSET(watch.m_socket, &reads);
+        event.m_isWritable = FD_ISSET(watch.m_socket, &writes);
+        event.m_isError = FD_ISSET(watch.m_socket, &excepts);
+        if (event.m_isReadable || event.m_isWritable || event.m_isError)
+            pEvents[count++] = event;
+    }
+    return count;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Poller.h"
+
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------------------
+// Portable level-triggered backend. Every wait rebuilds fd_sets from the watched sockets and scans them,
+// so it costs O(sockets) per wait and tops out at FD_SETSIZE sockets, or descriptors below FD_SETSIZE off Windows
+//--------------------------------------------------------------------------------------------------------------
+class SelectPoller final : public Poller
+{
+private:
+    struct Watch
+    {
+        SOCKET m_socket;
+        bool m_isWriteInterested;
+    };
+
+    std::vector<Watch> m_watches;
+
+public:
+    virtual bool Add(SOCKET socket) override;
+    virtual void Remove(SOCKET socket) override;
+    virtual void SetWriteInterest(SOCKET socket, bool isInterested) override;
+    virtual size_t Wait(PollEvent* pEvents, size_t maxEvents, int timeoutMs) override;
+};
@@ -0,0 +1,30 @@
+#include "SessionLog.h"
+
+SessionLog::SessionLog()
+    : m_messages{}
+    , m_nextSequence{ 1 }
+    , m_size{ 0 }
+{
+    static_assert((kCapacity & (kCapacity - 1)) == 0);
+}
+
+void SessionLog::Append(const Message& message)
+{
+    m_messages[m_nextSequence & (kCapacity - 1)].Set(message);
+    ++m_nextSequence;
+    m_size = (std::min)(m_size + 1, kCapacity);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Whether every message after lastSequence is still here
+//--------------------------------------------------------------------------------------------------------------
+bool SessionLog::Covers(size_t lastSequence) const
+{
+    return lastSequence <= GetLastSequence() && GetLastSequence() - lastSequence <= m_size;
+}
+
+const Message& SessionLog::Get(size_t sequence) const
+{
+    assert(sequence < m_nextSequence && m_nextSequence - sequence <= m_size);
+    return m_messages[sequence & (kCapacity - 1)].Get();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Network.h"
+
+//--------------------------------------------------------------------------------------------------------------
+// The last kCapacity messages that changed a session's game, each stamped with the next sequence. A player who
+// dropped gets what it missed from here, or a snapshot once the log has moved on past it
+//--------------------------------------------------------------------------------------------------------------
+class SessionLog
+{
+public:
+    static constexpr size_t kCapacity = 128;    // Power of two, many moves of a connection being down
+
+private:
+    std::array<AnyMessage, kCapacity> m_messages;
+    size_t m_nextSequence;  // Sequences start at 1, 0 means nothing seen yet
+    size_t m_size;
+
+public:
+    SessionLog();
+
+    size_t GetNextSequence() const { return m_nextSequence; }
+    size_t GetLastSequence() const { return m_nextSequence - 1; }
+
+    // message must be stamped with GetNextSequence()
+    void Append(const Message& message);
+    bool Covers(size_t lastSequence) const;
+    const Message& Get(size_t sequence) const;
+};
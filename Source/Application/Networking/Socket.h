@@ -0,0 +1,111 @@
+#pragma once
+
+//--------------------------------------------------------------------------------------------------------------
+// Sockets on every platform. Winsock names are kept, POSIX systems get small stand-ins for them
+//--------------------------------------------------------------------------------------------------------------
+#include <string.h>
+
+#ifdef _WIN32
+#define _WINSOCK_DEPRECATED_NO_WARNINGS
+#include <WinSock2.h>
+
+using SocketLength = int;
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using SOCKET = int;
+using SocketLength = socklen_t;
+using u_long = unsigned long;
+using u_short = unsigned short;
+static constexpr SOCKET INVALID_SOCKET = -1;
+static constexpr int SOCKET_ERROR = -1;
+
+struct WSAData {};
+inline int WSAStartup(int, WSAData*) { return 0; }
+inline int WSACleanup() { return 0; }
+inline int WSAGetLastError() { return errno; }
+inline int closesocket(SOCKET socket) { return ::close(socket); }
+#ifndef MAKEWORD
+#define MAKEWORD(low, high) ((low) | ((high) << 8))
+#endif
+#endif
+
+//--------------------------------------------------------------------------------------------------------------
+// Helper functions
+//--------------------------------------------------------------------------------------------------------------
+// Make calls on socket return at once instead of blocking. Returns false on failure
+inline bool SetNonBlocking(SOCKET socket)
+{
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket(socket, FIONBIO, &on) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+// One of the regions SendRegions gathers, see SetRegion
+#ifdef _WIN32
+using SendRegion = WSABUF;
+#else
+using SendRegion = iovec;
+#endif
+
+inline void SetRegion(SendRegion& region, const char* pBytes, size_t size)
+{
+#ifdef _WIN32
+    region.buf = const_cast<char*>(pBytes);
+    region.len = (ULONG)size;
+#else
+    region.iov_base = const_cast<char*>(pBytes);
+    region.iov_len = size;
+#endif
+}
+
+// Send count regions in one call, in order, like send does one. Returns the bytes sent or SOCKET_ERROR
+inline int SendRegions(SOCKET socket, SendRegion* pRegions, size_t count)
+{
+#ifdef _WIN32
+    DWORD sentBytes = 0;
+    if (WSASend(socket, pRegions, (DWORD)count, &sentBytes, 0, nullptr, nullptr) != 0)
+        return SOCKET_ERROR;
+    return (int)sentBytes;
+#else
+    return (int)writev(socket, pRegions, (int)count);
+#endif
+}
+
+// Return true if the last failed call only failed because the socket isn't ready, try again later
+inline bool IsWouldBlock()
+{
+#ifdef _WIN32
+    int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+#else
+    return errno == EWOULDBLOCK || errno == EAGAIN || errno == EINPROGRESS || errno == EINTR;
+#endif
+}
+
+// Return the error a non-blocking connect or a broken socket is holding, 0 if it's fine
+inline int GetPendingError(SOCKET socket)
+{
+    int error = 0;
+#ifdef _WIN32
+    int length = sizeof(error);
+    if (getsockopt(socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length) != 0)
+        return WSAGetLastError();
+#else
+    socklen_t length = sizeof(error);
+    if (getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &length) != 0)
+        return errno;
+#endif
+    return error;
+}
@@ -1,15 +1,63 @@
 #include "Application.h"
+#include "Networking/LobbyServer.h"
+#ifdef _WIN32
 #include <vld.h>
+#endif
+
+#include <csignal>
+#include <stdlib.h>
+#include <string.h>
 
 // -Host is charmander
 // Use mouse click and point to move pieces
 // -Press 'r' to restart
-// -There is a Macro called TESTING in GameState.cpp Line 7, Set it to 1 to only spawn 2 pieces for testing
+// -There is a Macro called TESTING in GameState.cpp Line 6, Set it to 1 to only spawn 2 pieces for testing
+// -Run with --lobby to host many games at once with no window, Ctrl+C stops it
+// -Run with --join N to play in the lobby's session N, the first two to join it get a seat each
+// -Run with --watch N to follow the lobby's session N without playing, any number of spectators can
+// -The server target is built with HEADLESS set: no window, it hosts with the engine playing, or joins a session with --join N
+
+static LobbyServer* s_pLobby = nullptr;
+
+static void OnStopSignal(int)
+{
+    if (s_pLobby)
+        s_pLobby->Stop();
+}
 
 int main(int argc, char* argv[])
 {
+    bool isLobby = false;
+    size_t sessionId = kInvalidIndex;
+    bool isWatching = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--lobby") == 0)
+            isLobby = true;
+        else if (strcmp(argv[i], "--join") == 0 && i + 1 < argc)
+            sessionId = (size_t)strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc)
+        {
+            sessionId = (size_t)strtoull(argv[++i], nullptr, 10);
+            isWatching = true;
+        }
+    }
+
+    if (isLobby)
+    {
+        LobbyServer lobby;
+        s_pLobby = &lobby;
+        std::signal(SIGINT, OnStopSignal);
+        if (lobby.Initialize())
+            lobby.Run();
+        lobby.Shutdown();
+        s_pLobby = nullptr;
+        return 0;
+    }
+
     App app;
-    if (app.Initialize())
+    if (app.Initialize(sessionId, isWatching))
         app.Run();
     app.Shutdown();
 
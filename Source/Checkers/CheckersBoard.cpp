@@ -5,45 +5,108 @@
 #include "Utils/Log/Log.h"
 
 #include "GameState.h"
+#if !HEADLESS
+#include "Piece.h"
+#endif
 
 CheckersBoard::CheckersBoard()
+#if HEADLESS
 	: m_running{ true }
+#else
+	: m_tiles{}
+	, m_selectedMoves{}
+	, m_clickedSquares{ 0 }
+	, m_running{ true }
 	, m_isSelecting{ true }
 	, m_holdingPieceIndex{ kInvalidIndex }
+#endif
+	, m_table{ kBotTableSizeMb }
+	, m_searchPool{ m_table, kBotThreadCount }
+	, m_tablebase{}
+	, m_adjudicatedWinner{ CheckersColor::kContinue }
+	, m_openingBook{}
+	, m_random{ std::random_device{}() }
+	, m_isBotPlaying{ false }
 {
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 // Init game state
-//	-pRenderer: I need this renderer to create piece texture
+//	-pRenderer: I need this renderer to create piece texture, unused in the headless server
+//	-isBotPlaying: If the engine plays this side instead of the mouse
 //---------------------------------------------------------------------------------------------------------------------
-void CheckersBoard::Init(SDL_Renderer* pRenderer, bool isClient)
+void CheckersBoard::Init([[maybe_unused]] SDL_Renderer* pRenderer, bool isClient, bool isBotPlaying)
 {
-	m_currentState.Init(pRenderer, isClient);
+	m_currentState.Init(isClient);
+	m_isBotPlaying = isBotPlaying;
+
+	// Optional, built by the tablebase tool
+	if (m_tablebase.Load(kTablebasePath))
+	{
+		m_searchPool.SetTablebase(&m_tablebase);
+		Log::Get().PrintInColor(Log::Color::kLightGray, "Loaded endgame tablebase up to %zd pieces\n", m_tablebase.GetMaxPieces());
+	}
+
+	// Optional, built by the book tool
+	if (m_openingBook.Load(kOpeningBookPath))
+		Log::Get().PrintInColor(Log::Color::kLightGray, "Loaded opening book with %zd moves\n", m_openingBook.GetEntryCount());
+
+#if !HEADLESS
+	// Set up game map
+	InitTiles();
+	SyncTiles(pRenderer);
+#endif
 }
 
+#if !HEADLESS
 //---------------------------------------------------------------------------------------------------------------------
 // Called every frame to render the world.
 //---------------------------------------------------------------------------------------------------------------------
 void CheckersBoard::Render(SDL_Renderer* pRenderer) const
 {
-	// SDL draw game board state
-	m_currentState.Render(pRenderer);
+	// SDL draw game board state, walk through tiles and render each of them
+	for (const Tile& tile : m_tiles)
+		tile.Render(pRenderer);
 }
+#endif
 
 void CheckersBoard::Shutdown()
 {
 	m_running = false;
 }
 
-void CheckersBoard::Remove(size_t index)
+//---------------------------------------------------------------------------------------------------------------------
+// Play a whole move the host accepted, on the state and on the tiles
+//---------------------------------------------------------------------------------------------------------------------
+void CheckersBoard::PlayMove(const ::Move& move)
 {
-	m_currentState.KillPieceAt(index);
+	m_currentState.PlayMove(move);
+#if !HEADLESS
+	size_t fromIndex = m_currentState.ToBoardIndex(GetIndexFromSquare(move.From()));
+	size_t destIndex = m_currentState.ToBoardIndex(GetIndexFromSquare(move.Dest()));
+	m_tiles[destIndex].SetPiece(m_tiles[fromIndex].GetPiece());
+	m_tiles[fromIndex].SetPiece(nullptr);
+
+	Bitboard captured = move.m_captured;
+	while (captured)
+		m_tiles[m_currentState.ToBoardIndex(GetIndexFromSquare(PopLowestSquare(captured)))].RemovePiece();
+#endif
 }
 
-void CheckersBoard::Move(size_t fromIndex, size_t destIndex)
+void CheckersBoard::Restart([[maybe_unused]] SDL_Renderer* pRenderer)
 {
-	m_currentState.MovePiece(fromIndex, destIndex);
+	m_currentState.Restart();
+#if !HEADLESS
+	SyncTiles(pRenderer);
+#endif
+}
+
+void CheckersBoard::ApplySnapshot(const Position& position, size_t moveCount, [[maybe_unused]] SDL_Renderer* pRenderer)
+{
+	m_currentState.ApplySnapshot(position, moveCount);
+#if !HEADLESS
+	SyncTiles(pRenderer);
+#endif
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -53,7 +116,8 @@ void CheckersBoard::Move(size_t fromIndex, size_t destIndex)
 bool CheckersBoard::ShouldContinue()
 {
 	// Continue game
-	if (m_currentState.CheckerWinner() == CheckersColor::kContinue)
+	CheckersColor winner = GetWinner();
+	if (winner == CheckersColor::kContinue)
 		return m_running;
 
 	// Has a winner
@@ -61,7 +125,7 @@ bool CheckersBoard::ShouldContinue()
 	if (!s_logged)
 	{
 		Log::Get().PrintInColor(Log::Color::kLightGray, "Winner is ");
-		Log::Get().PrintInColor(Log::Color::kLightCyan, "%s\n", (m_currentState.CheckerWinner() == CheckersColor::kDark ? ("Charmander") : ("Pikachu")));
+		Log::Get().PrintInColor(Log::Color::kLightCyan, "%s\n", (winner == CheckersColor::kDark ? ("Charmander") : ("Pikachu")));
 		s_logged = true;
 	}
 
@@ -69,29 +133,53 @@ bool CheckersBoard::ShouldContinue()
 	return m_running;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+// Returns the winner, or kContinue. The host also calls the game once the tablebase says one side has a forced win
+//---------------------------------------------------------------------------------------------------------------------
+CheckersColor CheckersBoard::GetWinner()
+{
+	if (m_adjudicatedWinner != CheckersColor::kContinue)
+		return m_adjudicatedWinner;
+
+	CheckersColor winner = m_currentState.CheckerWinner();
+	if (winner != CheckersColor::kContinue || m_currentState.GetPlayer() != CheckersColor::kDark)
+		return winner;
+
+	const Position& position = m_currentState.GetPosition();
+	TablebaseResult result;
+	if (!m_tablebase.Probe(position, result) || result.m_outcome == TablebaseOutcome::kDraw)
+		return CheckersColor::kContinue;
+
+	m_adjudicatedWinner = (result.m_outcome == TablebaseOutcome::kWin) ? position.m_sideToMove : GetOpponent(position.m_sideToMove);
+	Log::Get().PrintInColor(Log::Color::kLightGray, "Tablebase: forced win in %zd plies\n", result.m_distance);
+	return m_adjudicatedWinner;
+}
+
+#if !HEADLESS
 //--------------------------------------------------------------------------------------------------------------
 // Processes the events we care about.  Returns true if we want to exit the program, false if not.
 //--------------------------------------------------------------------------------------------------------------
 bool CheckersBoard::HandleInput(SDL_Event* pEvent, NetworkingBase* pNetwork)
 {
-	char msg[kLimit];
-
 	switch (pEvent->type)
 	{
 	case SDL_KEYDOWN:
 		// Restart
 		if (pEvent->key.keysym.sym == kRestartKey && m_currentState.GetPlayer() == CheckersColor::kDark)
 		{
-			sprintf_s(msg, kRestart.c_str());
-			pNetwork->HandleInput(msg);
+			pNetwork->HandleInput(RestartMessage());
 		}
 		break;
 
 	case SDL_MOUSEBUTTONDOWN:
+		// The engine is playing this side
+		if (m_isBotPlaying)
+			break;
+
 		// Select a piece to move
 		if (m_isSelecting)
 		{
-			m_holdingPieceIndex = m_currentState.OnSelected(pEvent->button.x, pEvent->button.y);
+			m_holdingPieceIndex = OnSelected(pEvent->button.x, pEvent->button.y);
 
 			// If the position we clicked has a piece on it, we are not moving this piece
 			if (m_holdingPieceIndex != kInvalidIndex)
@@ -100,32 +188,29 @@ bool CheckersBoard::HandleInput(SDL_Event* pEvent, NetworkingBase* pNetwork)
 		// Try to drop if the move is legit, notify networking to work
 		else
 		{
-			// If we succeded moved the holding piece to the new destination, tell the network to work
-			MoveResult moveResult = m_currentState.IsValidMove(pEvent->button.x, pEvent->button.y);
-
 			// If it's a legit move, notify network to perform so
-			if (moveResult.m_destIndex != kInvalidIndex)
+			::Move move;
+			DropResult result = DropPiece(pEvent->button.x, pEvent->button.y, move);
+			if (result == DropResult::kPartial)
 			{
-				sprintf_s(msg, kMove.c_str(), m_holdingPieceIndex, moveResult.m_destIndex, size_t(m_currentState.GetPlayer() == CheckersColor::kDark));
-				pNetwork->HandleInput(msg);
-
-				for (size_t pieceToKill : moveResult.m_piecesToKill)
-				{
-					sprintf_s(msg, kKill.c_str(), pieceToKill, m_currentState.GetPlayer() == CheckersColor::kDark);
-					pNetwork->HandleInput(msg);
-				}
+				// Keep holding the piece until the path is clear
+				break;
+			}
+			else if (result == DropResult::kMove)
+			{
+				SendMove(move, pNetwork);
 			}
 			// If it's not legit, make the selected piece back to original position
 			else
 			{
 				Log::Get().PrintInColor(Log::Color::kMagenta, "Invalid move\n");
-				m_currentState.ResetSelectedPiece(m_holdingPieceIndex);
+				ResetSelectedPiece(m_holdingPieceIndex);
 			}
 
 			// Set holding piece, high-lighted tiles, and selecting back
 			m_holdingPieceIndex = kInvalidIndex;
 			m_isSelecting = true;
-			m_currentState.ResetHighlightedTiles();
+			ResetHighlightedTiles();
 		}
 
 		break;
@@ -133,3 +218,229 @@ bool CheckersBoard::HandleInput(SDL_Event* pEvent, NetworkingBase* pNetwork)
 
 	return m_running;
 }
+#endif
+
+//---------------------------------------------------------------------------------------------------------------------
+// Let the engine pick a move when it's this side's turn, and send it the same way a mouse move is sent.
+// Book moves are instant, anything else blocks for up to kBotTimeBudgetMs
+//---------------------------------------------------------------------------------------------------------------------
+void CheckersBoard::UpdateBot(NetworkingBase* pNetwork)
+{
+	const Position& position = m_currentState.GetPosition();
+	if (!m_isBotPlaying || position.m_sideToMove != m_currentState.GetPlayer())
+		return;
+
+	SearchResult result;
+	if (m_openingBook.PickMove(position, m_random(), result.m_bestMove))
+	{
+		Log::Get().PrintInColor(Log::Color::kLightGray, "Book plays ");
+		Log::Get().PrintInColor(Log::Color::kLightCyan, "%s\n", MoveToString(result.m_bestMove).c_str());
+	}
+	else
+	{
+		SearchLimits limits;
+		limits.m_timeBudgetMs = kBotTimeBudgetMs;
+		result = m_searchPool.Search(position, limits);
+		if (!result.m_hasMove)
+			return;
+
+		Log::Get().PrintInColor(Log::Color::kLightGray, "Engine plays ");
+		Log::Get().PrintInColor(Log::Color::kLightCyan, "%s", MoveToString(result.m_bestMove).c_str());
+		Log::Get().PrintInColor(Log::Color::kLightGray, " (depth %zd, score %d)\n", result.m_depth, result.m_score);
+	}
+
+	SendMove(result.m_bestMove, pNetwork);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Tell the network to play move, path and captures in one message. The host checks it and tells everyone
+//---------------------------------------------------------------------------------------------------------------------
+void CheckersBoard::SendMove(const ::Move& move, NetworkingBase* pNetwork)
+{
+	size_t isHostCalling = size_t(m_currentState.GetPlayer() == CheckersColor::kDark);
+	pNetwork->HandleInput(PlayMessage(move, isHostCalling));
+}
+
+#if !HEADLESS
+//---------------------------------------------------------------------------------------------------------------------
+// Place every tile on screen and color it
+//---------------------------------------------------------------------------------------------------------------------
+void CheckersBoard::InitTiles()
+{
+	size_t index = 0;
+
+	// Row
+	for (size_t row = 0; row < kBoardHeight; ++row)
+	{
+		// Col
+		for (size_t col = 0; col < kBoardWidth; ++col)
+		{
+			// Set tile's position
+			m_tiles[index].SetPosition(col, row);
+
+			// Pieces only stand on dark cells
+			if (!IsPlayableIndex(index))
+				m_tiles[index].SetSide(CheckersColor::kLight);
+
+			++index;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Rebuild every tile's piece from the game state
+//		-pRenderer: Used when creating pieces
+//---------------------------------------------------------------------------------------------------------------------
+void CheckersBoard::SyncTiles(SDL_Renderer* pRenderer)
+{
+	for (Tile& tile : m_tiles)
+		tile.RemovePiece();
+
+	const Position& position = m_currentState.GetPosition();
+	for (size_t side = 0; side < (size_t)CheckersColor::kCount; ++side)
+	{
+		Bitboard pieces = position.m_pieces[side];
+		while (pieces)
+		{
+			size_t index = m_currentState.ToBoardIndex(GetIndexFromSquare(PopLowestSquare(pieces)));
+			m_tiles[index].SetPiece(new Piece((CheckersColor)side, pRenderer));
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Called whenever we get a tile select event. Returns selected tile index if it's valid, kInvalidIndex if not
+//      -mouseX: The X pixel position on the screen where the mouse clicked.
+//      -mouseY: The Y pixel position on the screen where the mouse clicked.
+//---------------------------------------------------------------------------------------------------------------------
+size_t CheckersBoard::OnSelected(Sint32 mouseX, Sint32 mouseY)
+{
+	size_t index = GetIndexFromPixel(mouseX, mouseY);
+
+	// Get the piece on it
+	Piece* pSelectedPiece = m_tiles[index].GetPiece();
+
+	// if there is no piece on it, or it's not my piece, return invalid index
+	if (!pSelectedPiece || !m_currentState.GetPosition().HasPiece(m_currentState.GetPlayer(), GetSquareFromIndex(m_currentState.ToBoardIndex(index))))
+		return kInvalidIndex;
+
+	// High light all possible moves, a piece that can't move (or must let another piece capture) can't be picked up
+	if (HighLightAllPossibleTiles(index) == 0)
+		return kInvalidIndex;
+
+	// If we reach this point, means the selected piece is valid and is mine.
+	// Perform on selected behavior of this piece
+	pSelectedPiece->OnSelected();
+
+	return index;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Called when the movement was invalid
+//		-tileIndex: The selected piece's tile index
+//---------------------------------------------------------------------------------------------------------------------
+void CheckersBoard::ResetSelectedPiece(size_t tileIndex)
+{
+	m_tiles[tileIndex].GetPiece()->UnSelect();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Keep the selected piece's moves that go through where we clicked, and every square clicked before.
+// A move is picked once it's the only one left, or the only one that stops there. Captures that share their start and
+// end squares can only be told apart by the squares between, so those are high-lighted for the next click
+//      -mouseX: The X pixel position on the screen where the mouse clicked.
+//      -mouseY: The Y pixel position on the screen where the mouse clicked.
+//      -move: The move, with its whole path and captures
+//---------------------------------------------------------------------------------------------------------------------
+DropResult CheckersBoard::DropPiece(Sint32 mouseX, Sint32 mouseY, ::Move& move)
+{
+	size_t clickedIndex = GetIndexFromPixel(mouseX, mouseY);
+	if (!m_tiles[clickedIndex].HighLighted())
+		return DropResult::kInvalid;
+
+	size_t clickedSquare = GetSquareFromIndex(m_currentState.ToBoardIndex(clickedIndex));
+	m_clickedSquares |= GetSquareMask(clickedSquare);
+
+	MoveList candidates;
+	Bitboard pathSquares = 0;	// Where the candidates go, the piece's own square aside
+	const ::Move* pStopsHere = nullptr;
+	size_t stopsHereCount = 0;
+	for (const ::Move& selectedMove : m_selectedMoves)
+	{
+		Bitboard squares = 0;
+		for (size_t i = 1; i < selectedMove.m_pathLength; ++i)
+			squares |= GetSquareMask(selectedMove.m_path[i]);
+		if ((squares & m_clickedSquares) != m_clickedSquares)
+			continue;
+
+		candidates.m_moves[candidates.m_count++] = selectedMove;
+		pathSquares |= squares;
+		if (selectedMove.Dest() == clickedSquare)
+		{
+			pStopsHere = &selectedMove;
+			++stopsHereCount;
+		}
+	}
+
+	if (candidates.Empty())
+		return DropResult::kInvalid;
+
+	if (candidates.Size() == 1 || stopsHereCount == 1)
+	{
+		move = (candidates.Size() == 1) ? candidates[0] : *pStopsHere;
+		return DropResult::kMove;
+	}
+
+	// Paths through the same squares in another order aren't worth asking about, the first one is played
+	Bitboard unclicked = pathSquares & ~m_clickedSquares;
+	if (unclicked == 0)
+	{
+		move = candidates[0];
+		return DropResult::kMove;
+	}
+
+	m_selectedMoves = candidates;
+	for (Tile& tile : m_tiles)
+		tile.Reset();
+	while (unclicked)
+		m_tiles[m_currentState.ToBoardIndex(GetIndexFromSquare(PopLowestSquare(unclicked)))].SetHighLighted();
+
+	Log::Get().PrintInColor(Log::Color::kYellow, "%zd captures fit, click a square along the one to play\n", candidates.Size());
+	return DropResult::kPartial;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// High-light the destination of every legal move of the piece at beginIndex, returns how many moves it has
+//		-beginIndex: The selected piece's tile index
+//---------------------------------------------------------------------------------------------------------------------
+size_t CheckersBoard::HighLightAllPossibleTiles(size_t beginIndex)
+{
+	MoveList allMoves;
+	GenerateMoves(m_currentState.GetPosition(), m_currentState.GetPlayer(), allMoves);
+
+	// Only keep the selected piece's moves
+	size_t beginSquare = GetSquareFromIndex(m_currentState.ToBoardIndex(beginIndex));
+	m_selectedMoves.Clear();
+	for (const ::Move& move : allMoves)
+	{
+		if (move.From() != beginSquare)
+			continue;
+
+		m_selectedMoves.m_moves[m_selectedMoves.m_count++] = move;
+		m_tiles[m_currentState.ToBoardIndex(GetIndexFromSquare(move.Dest()))].SetHighLighted();
+	}
+
+	return m_selectedMoves.Size();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Reset high-lighted tiles
+//---------------------------------------------------------------------------------------------------------------------
+void CheckersBoard::ResetHighlightedTiles()
+{
+	for (Tile& tile : m_tiles)
+		tile.Reset();
+	m_selectedMoves.Clear();
+	m_clickedSquares = 0;
+}
+#endif
@@ -2,11 +2,31 @@
 
 #include "GameState.h"
 #include "CheckersConstants.h"
+#include "Engine/OpeningBook.h"
+#include "Engine/SearchPool.h"
+
+#include <random>
+
+#if HEADLESS
+struct SDL_Renderer;		// Always nullptr, nothing is drawn
+#else
+#include "Tile.h"
 
 #include <SDL.h>
+#endif
 
 class NetworkingBase;
 
+#if !HEADLESS
+// What a click does with the piece the player holds
+enum class DropResult
+{
+	kInvalid,	// Not somewhere the piece can go, it's put back
+	kMove,		// One legal move fits the squares clicked, it's played
+	kPartial,	// Several captures still fit, another square along the path picks one
+};
+#endif
+
 //--------------------------------------------------------------------------------------------------------------
 // Represents the checkers world
 //--------------------------------------------------------------------------------------------------------------
@@ -14,23 +34,67 @@ class CheckersBoard
 {
 private:
 	GameState m_currentState;
+
+#if !HEADLESS
+	// Game map array, render-side view of m_currentState from this player's point of view
+	Tile m_tiles[kBoardSize];
+
+	// Legal moves of the selected piece that go through every square clicked since, each high-lighted tile is on one
+	MoveList m_selectedMoves;
+	Bitboard m_clickedSquares;	// Where the player clicked while the selected moves were narrowed down
+#endif
+
 	bool m_running;
+#if !HEADLESS
 	bool m_isSelecting;	// If current player should select or drop a piece
 	size_t m_holdingPieceIndex;
-	
+#endif
+
+	// Plays this side instead of the mouse when m_isBotPlaying
+	TranspositionTable m_table;
+	SearchPool m_searchPool;
+
+	// Lets the host call won endgames early, and the bot play them perfectly
+	Tablebase m_tablebase;
+	CheckersColor m_adjudicatedWinner;		// kContinue until the game is called
+
+	// Opening moves cost the bot a lookup instead of a search
+	OpeningBook m_openingBook;
+	std::mt19937_64 m_random;				// Picks among weighted book moves
+	bool m_isBotPlaying;
+
 public:
 	CheckersBoard();
 
-	void Init(SDL_Renderer* pRenderer, bool isClient);
-	void Render(SDL_Renderer* pRenderer) const;
+	void Init(SDL_Renderer* pRenderer, bool isClient, bool isBotPlaying);
 	void Shutdown();
+	void UpdateBot(NetworkingBase* pNetwork);
+#if !HEADLESS
+	void Render(SDL_Renderer* pRenderer) const;
 	bool HandleInput(SDL_Event* pEvent, NetworkingBase* pNetwork);
+#endif
 
-	void Remove(size_t index);
-	void Move(size_t fromIndex, size_t destIndex);
-	void Restart(SDL_Renderer* pRenderer) { m_currentState.Restart(pRenderer); }
+	void PlayMove(const ::Move& move);
+	void Restart(SDL_Renderer* pRenderer);
 	bool ShouldContinue();
-	AllPiecesIndex GetAllPiecesIndex() { return m_currentState.GetAllPiecesIndex(); }
-	void PlacePiece(CheckersColor side, size_t index, SDL_Renderer* pRenderer) { m_currentState.PlacePiece(side, index, pRenderer); }
-};
+	CheckersColor GetWinner();
+	void SetWinner(CheckersColor side) { m_adjudicatedWinner = side; }
+	void ApplySnapshot(const Position& position, size_t moveCount, SDL_Renderer* pRenderer);
+	const Position& GetPosition() const { return m_currentState.GetPosition(); }
+	size_t GetMoveCount() const { return m_currentState.GetMoveCount(); }
+	void SetTurn(CheckersColor side) { m_currentState.SetSideToMove(side); }
+	void SetSeat(CheckersColor side) { m_currentState.SetPlayer(side); }
+	ZobristKey GetHash() const { return m_currentState.GetHash(); }
 
+private:
+	void SendMove(const ::Move& move, NetworkingBase* pNetwork);
+#if !HEADLESS
+	void InitTiles();
+	void SyncTiles(SDL_Renderer* pRenderer);
+	size_t OnSelected(Sint32 mouseX, Sint32 mouseY);
+	DropResult DropPiece(Sint32 mouseX, Sint32 mouseY, ::Move& move);
+	void ResetSelectedPiece(size_t tileIndex);
+	void ResetHighlightedTiles();
+	size_t HighLightAllPossibleTiles(size_t beginIndex);
+#endif
+};
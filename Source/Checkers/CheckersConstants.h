@@ -1,12 +1,16 @@
 #pragma once
 
-#include "Utils/Math/Vector2.h"
 #include <string>
 #include <numeric>
 #include <utility>
 #include <vector>
 #include <array>
-#include <SDL.h>
+#include "Utils/Platform/SecureCrt.h"
+
+// Set to 1 by the build for the server target: no window, rendering, sound or mouse, the engine plays every local side
+#ifndef HEADLESS
+#define HEADLESS 0
+#endif
 
 //--------------------------------------------------------------------------------------------------------------
 // Constants
@@ -24,17 +28,23 @@ static constexpr int kTileHeight = kWindowHeight / kBoardHeight;
 
 // Gameplay
 static constexpr size_t kInvalidIndex = (std::numeric_limits<size_t>::max)();
-static constexpr SDL_KeyCode kRestartKey = SDLK_r;		// Server press this char to restart
+static constexpr char kRestartKey = 'r';				// Server press this char to restart, the same as SDLK_r
 
 // Networking messages
 static constexpr size_t kLimit = 128;
-inline static const std::string kKill = "KILL %zd %zd\n";		// Kill index, isHostcCalling
-inline static const std::string kMove = "MOVE %zd %zd %zd\n";	// From index, dest Index, isHostCalling
+inline static const std::string kPlay = "PLAY %zd %zd %x %s\n";	// isHostCalling, sequence, captured squares, squares the piece stands on joined by '-'
 inline static const std::string kGameFull = "GAME IS FULL\n";	
-inline static const std::string kActive = "ACTIVE\n";	
-inline static const std::string kPiece = "PIECE %zd AT %zd\n";	// zd for piece's side (0 for Host/Dark or 1 for Client/Light), zd for index
 inline static const std::string kTurn = "TURN %zd\n";			// zd for turn (0 for Host/Dark or 1 for Client/Light)
-inline static const std::string kRestart = "RESTART\n";		
+inline static const std::string kRestart = "RESTART %zd\n";		// zd for the sequence, 0 when asked for
+inline static const std::string kWinner = "WINNER %zd\n";		// zd for the winning side, sent by the host when its game ends
+inline static const std::string kHash = "HASH %llx\n";		// Host's position hash, the client compares it with its own to catch desyncs
+inline static const std::string kJoin = "JOIN %zd\n";			// zd for the lobby session to play in, created by the first one to join
+inline static const std::string kSeat = "SEAT %zd %llx\n";		// zd for the side the lobby seated this client on (0 for Dark or 1 for Light), llx for the token to resume it with
+inline static const std::string kSnapshot = "SNAPSHOT %x %x %x %zd %zd %llx %zd\n";	// Dark, light and king squares, side to move, move count and hash of the host's position, last sequence in it
+inline static const std::string kResume = "RESUME %zd %zd %zd %llx\n";	// Session, side, the last sequence seen and the seat's token, to take a seat back after a dropped connection
+inline static const std::string kWatch = "WATCH %zd\n";		// zd for the lobby session to follow without a seat, as many can watch as want to
+inline static const std::string kHello = "HELLO %zd\n";		// zd for the binary protocol version the client speaks, a server that does too answers kBinary
+inline static const std::string kBinary = "BINARY %zd\n";		// zd for the binary protocol version, the sender writes frames instead of lines after it
 
 //--------------------------------------------------------------------------------------------------------------
 // Enums
@@ -49,26 +59,17 @@ enum class CheckersColor : size_t
 	kContinue = 3	// If current game state has no winner, return this in check winner function
 };
 
-//--------------------------------------------------------------------------------------------------------------
-// Structs
-//--------------------------------------------------------------------------------------------------------------
-// Used when moving a piece, bool is if it's a valid move, size_t is the opponent's piece index if jump occured, kInvalidIndex if the move didn't involve killing
-struct MoveResult
+// Diagonal directions on the board, up is toward the host's top row
+enum class Direction : size_t
 {
-	size_t m_destIndex = kInvalidIndex;
-	std::vector<size_t> m_piecesToKill;
+	kUpLeft = 0,
+	kUpRight = 1,
+	kDownLeft = 2,
+	kDownRight = 3,
 
-	MoveResult() 
-		: m_destIndex{ kInvalidIndex }
-		, m_piecesToKill{  }
-	{}
+	kCount = 4
 };
 
-//--------------------------------------------------------------------------------------------------------------
-// Alias
-//--------------------------------------------------------------------------------------------------------------
-using AllPiecesIndex = std::array<std::vector<size_t>, (size_t)CheckersColor::kCount>;	// two vectors of index, one for dark and the other for light
-
 //--------------------------------------------------------------------------------------------------------------
 // Helper functions
 //--------------------------------------------------------------------------------------------------------------
@@ -102,11 +103,38 @@ constexpr size_t GetIndexFromPixel(int pixelX, int pixelY)
 	return GetIndexFromPos(gridX, gridY);
 }
 
-// Return a Vector2 by index
-//		-index: The index to get Vector2
-inline Vector2 GetVec2FromIndex(size_t index)
+// Return the tile index a number of diagonal steps away, kInvalidIndex if that leaves the board
+//		-index: The tile to start from
+//		-dir: Which diagonal to walk along
+//		-steps: How many tiles to walk
+constexpr size_t GetDiagonalIndex(size_t index, Direction dir, size_t steps)
 {
-	size_t x = index % kBoardWidth;
-	size_t y = index / kBoardWidth;
-	return Vector2((float)x, (float)y);
-}
\ No newline at end of file
+	int x = (int)(index % kBoardWidth);
+	int y = (int)(index / kBoardWidth);
+	x += (dir == Direction::kUpLeft || dir == Direction::kDownLeft) ? -(int)steps : (int)steps;
+	y += (dir == Direction::kUpLeft || dir == Direction::kUpRight) ? -(int)steps : (int)steps;
+
+	if (x < 0 || x >= (int)kBoardWidth || y < 0 || y >= (int)kBoardHeight)
+		return kInvalidIndex;
+	return GetIndexFromPos((size_t)x, (size_t)y);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Lookup tables, built at compile time
+//--------------------------------------------------------------------------------------------------------------
+using DiagonalTable = std::array<std::array<size_t, (size_t)Direction::kCount>, kBoardSize>;
+
+constexpr DiagonalTable BuildDiagonalTable(size_t steps)
+{
+	DiagonalTable table{};
+	for (size_t index = 0; index < kBoardSize; ++index)
+	{
+		for (size_t dir = 0; dir < (size_t)Direction::kCount; ++dir)
+			table[index][dir] = GetDiagonalIndex(index, (Direction)dir, steps);
+	}
+	return table;
+}
+
+// For every tile and direction: the tile next to it, and the tile a jump over that neighbor lands on. kInvalidIndex off the board
+static constexpr DiagonalTable kNeighborIndex = BuildDiagonalTable(1);
+static constexpr DiagonalTable kJumpIndex = BuildDiagonalTable(2);
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "GameRecord.h"
+
+#include <ctype.h>
+
+//---------------------------------------------------------------------------------------------------------------------
+// Result of a game from side's point of view: 1 for a win, 0 for a loss, 0.5 for a draw or an unknown result
+//---------------------------------------------------------------------------------------------------------------------
+double GetGameScore(GameResult result, CheckersColor side)
+{
+	if (result == GameResult::kDarkWins)
+		return (side == CheckersColor::kDark) ? 1.0 : 0.0;
+	if (result == GameResult::kLightWins)
+		return (side == CheckersColor::kLight) ? 1.0 : 0.0;
+	return 0.5;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Find the legal move of position written as text, returns false if there's none or more than one.
+// Jumps may give only their ends, "15x31", when that's not ambiguous
+//---------------------------------------------------------------------------------------------------------------------
+bool ParseMove(const Position& position, const std::string& text, Move& move)
+{
+	// Squares in the order they're written
+	std::vector<size_t> squares;
+	size_t number = 0;
+	bool hasNumber = false;
+	for (char c : text)
+	{
+		if (isdigit((unsigned char)c))
+		{
+			number = number * 10 + (size_t)(c - '0');
+			hasNumber = true;
+		}
+		else if ((c == '-' || c == 'x' || c == 'X') && hasNumber)
+		{
+			squares.emplace_back(GetSquareFromNotation(number));
+			number = 0;
+			hasNumber = false;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	if (!hasNumber)
+		return false;
+	squares.emplace_back(GetSquareFromNotation(number));
+	if (squares.size() < 2)
+		return false;
+
+	MoveList moves;
+	GenerateMoves(position, position.m_sideToMove, moves);
+
+	size_t matches = 0;
+	for (const Move& candidate : moves)
+	{
+		if (candidate.From() != squares.front() || candidate.Dest() != squares.back())
+			continue;
+
+		// A full path must match square for square
+		if (squares.size() > 2)
+		{
+			if (squares.size() != candidate.m_pathLength)
+				continue;
+
+			bool isSamePath = true;
+			for (size_t i = 0; i < squares.size(); ++i)
+				isSamePath = isSamePath && (candidate.m_path[i] == squares[i]);
+			if (!isSamePath)
+				continue;
+		}
+
+		move = candidate;
+		++matches;
+	}
+	return matches == 1;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Skip whitespace, then read one token. A [tag] or a {comment} is one token, brackets included.
+// Returns false at the end of input
+//---------------------------------------------------------------------------------------------------------------------
+static bool ReadToken(std::istream& input, std::string& token)
+{
+	token.clear();
+	while (isspace(input.peek()))
+		input.get();
+
+	int c = input.get();
+	if (c == EOF)
+		return false;
+
+	token += (char)c;
+	if (c == '[' || c == '{')
+	{
+		char closing = (c == '[') ? ']' : '}';
+		while ((c = input.get()) != EOF)
+		{
+			token += (char)c;
+			if (c == closing)
+				break;
+		}
+		return true;
+	}
+
+	while (input.peek() != EOF && !isspace(input.peek()) && input.peek() != '[' && input.peek() != '{')
+		token += (char)input.get();
+	return true;
+}
+
+// Returns true if token ends a game, and what the result is
+static bool ParseResult(const std::string& token, GameResult& result)
+{
+	if (token == "1-0" || token == "2-0")
+		result = GameResult::kDarkWins;
+	else if (token == "0-1" || token == "0-2")
+		result = GameResult::kLightWins;
+	else if (token == "1/2-1/2" || token == "1-1")
+		result = GameResult::kDraw;
+	else if (token == "*")
+		result = GameResult::kUnknown;
+	else
+		return false;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Read the next game of input, returns false at the end of input
+//		-isValid: False if a move isn't legal. The rest of the game is still consumed, so reading can go on
+//---------------------------------------------------------------------------------------------------------------------
+bool ReadGameRecord(std::istream& input, GameRecord& record, bool& isValid)
+{
+	record = GameRecord();
+	isValid = true;
+
+	Position position = record.m_start;
+	bool hasContent = false;
+	std::string token;
+	while (true)
+	{
+		// A tag after the moves starts the next game, which may not have written a result
+		while (isspace(input.peek()))
+			input.get();
+		if (input.peek() == '[' && !record.m_moves.empty())
+			return true;
+
+		if (!ReadToken(input, token))
+			return hasContent;
+		hasContent = true;
+
+		if (token[0] == '{')
+			continue;
+
+		if (token[0] == '[')
+		{
+			static const std::string kFenTag = "[FEN \"";
+			if (token.compare(0, kFenTag.size(), kFenTag) == 0)
+			{
+				std::string fen = token.substr(kFenTag.size(), token.find('"', kFenTag.size()) - kFenTag.size());
+				if (!Position::FromFen(fen, record.m_start))
+					isValid = false;
+				position = record.m_start;
+			}
+			continue;
+		}
+
+		if (ParseResult(token, record.m_result))
+			return true;
+
+		// Move numbers, "12." or "12...", may be glued to the move that follows
+		size_t numberEnd = token.rfind('.');
+		if (numberEnd != std::string::npos)
+			token.erase(0, numberEnd + 1);
+		if (token.empty() || !isValid)
+			continue;
+
+		Move move;
+		if (!ParseMove(position, token, move))
+		{
+			isValid = false;
+			continue;
+		}
+		ApplyMove(position, move);
+		record.m_moves.emplace_back(move);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns record as PDN, ending with an empty line
+//---------------------------------------------------------------------------------------------------------------------
+std::string GameRecordToString(const GameRecord& record)
+{
+	static constexpr size_t kMovesPerLine = 8;
+
+	std::string text;
+	if (!(record.m_start == Position::StartPosition()))
+		text += "[FEN \"" + record.m_start.ToFen() + "\"]\n";
+
+	static const char* kResults[] = { "*", "1-0", "0-1", "1/2-1/2" };
+	text += std::string("[Result \"") + kResults[(size_t)record.m_result] + "\"]\n";
+
+	// Move numbers count full moves, the first one may be light's when the game starts from a FEN
+	size_t ply = (record.m_start.m_sideToMove == CheckersColor::kDark) ? 0 : 1;
+	for (size_t i = 0; i < record.m_moves.size(); ++i, ++ply)
+	{
+		if (ply % 2 == 0 || i == 0)
+			text += std::to_string(ply / 2 + 1) + ((ply % 2 == 0) ? ". " : "... ");
+
+		text += MoveToString(record.m_moves[i]);
+		text += ((i + 1) % kMovesPerLine == 0) ? "\n" : " ";
+	}
+	text += kResults[(size_t)record.m_result];
+	text += "\n\n";
+	return text;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Position.h"
+#include "MoveGenerator.h"
+#include "CheckersConstants.h"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------------------
+// How a recorded game ended
+//--------------------------------------------------------------------------------------------------------------
+enum class GameResult : uint8_t
+{
+	kUnknown,		// "*", unfinished or not recorded
+	kDarkWins,		// "1-0", dark plays black and moves first
+	kLightWins,		// "0-1"
+	kDraw			// "1/2-1/2"
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// One game as a list of moves from a start position. Read from and written as PDN: optional [Tag "value"]
+// lines, then the moves in notation with or without move numbers, ended by the result. Only the FEN tag is
+// used, every other tag and {comment} is skipped
+//--------------------------------------------------------------------------------------------------------------
+struct GameRecord
+{
+	Position m_start = Position::StartPosition();
+	std::vector<Move> m_moves;
+	GameResult m_result = GameResult::kUnknown;
+};
+
+// Result of a game from side's point of view: 1 for a win, 0 for a loss, 0.5 for a draw or an unknown result
+double GetGameScore(GameResult result, CheckersColor side);
+
+// Find the legal move of position written as text. Jumps may give only their ends, "15x31", when that's not ambiguous
+bool ParseMove(const Position& position, const std::string& text, Move& move);
+
+// Read the next game of input, returns false at the end of input. isValid is false if a move isn't legal,
+// the game is still consumed so reading can go on with the next one
+bool ReadGameRecord(std::istream& input, GameRecord& record, bool& isValid);
+
+// Returns record as PDN, ending with an empty line
+std::string GameRecordToString(const GameRecord& record);
@@ -1,49 +1,56 @@
 #include "GameState.h"
 
-#include "CheckersBoard.h"
-#include "Piece.h"
-
-#include <unordered_map>
+#include <assert.h>
 
 // When set to 1, only spawn two pieces
 #define TESTING 0
 
 GameState::GameState()
-	: m_tiles{}
-	, m_myPieces{}
-	, m_otherPieces{}
+	: m_position{}
+	, m_hash{ ComputeHash(m_position) }
+	, m_moveCount{ 0 }
 	, m_currentPlayer{ CheckersColor::kDark }
 	, m_doneInit{ false }
+	, m_undoStack{}
 {
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 // Reset game map
-//		-pRenderer: I need this renderer to create piece texture
 //		-isClient: If this is an client, then this board should place light pieces at the bottom, vice-versa
 //---------------------------------------------------------------------------------------------------------------------
-void GameState::Init(SDL_Renderer* pRenderer, bool isClient)
+void GameState::Init(bool isClient)
 {
+	m_undoStack.clear();
+	m_moveCount = 0;
+
+	// The client waits for the host to send the board
 	if (isClient)
-		m_currentPlayer = CheckersColor::kLight;
-	else
 	{
-		m_doneInit = true;
-		m_currentPlayer = CheckersColor::kDark;
+		m_currentPlayer = CheckersColor::kLight;
+		m_position.Clear();
+		m_hash = ComputeHash(m_position);
+		return;
 	}
 
-	// Set up game map
-	InitMap(pRenderer, false);
-}
+	m_doneInit = true;
+	m_currentPlayer = CheckersColor::kDark;
 
-//---------------------------------------------------------------------------------------------------------------------
-// Draw tiles and pieces on it
-//---------------------------------------------------------------------------------------------------------------------
-void GameState::Render(SDL_Renderer* pRenderer) const
-{
-	// Walk through tiles and render each of them
-	for (const Tile& tile : m_tiles)
-		tile.Render(pRenderer);
+#if TESTING
+	size_t lightPiece = 53;
+	size_t lightPiece2 = 35;
+	size_t lightPiece3 = 19;
+	size_t darkPiece = 62;
+
+	m_position.Clear();
+	m_position.Place(CheckersColor::kLight, GetSquareFromIndex(lightPiece), false);
+	m_position.Place(CheckersColor::kLight, GetSquareFromIndex(lightPiece2), false);
+	m_position.Place(CheckersColor::kLight, GetSquareFromIndex(lightPiece3), false);
+	m_position.Place(CheckersColor::kDark, GetSquareFromIndex(darkPiece), false);
+#else
+	m_position = Position::StartPosition();
+#endif
+	m_hash = ComputeHash(m_position);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -56,386 +63,153 @@ CheckersColor GameState::CheckerWinner() const
 		return CheckersColor::kContinue;
 
 	// I won
-	if (m_myPieces.size() <= 0)
-		return (m_currentPlayer == CheckersColor::kDark) ? (CheckersColor::kLight) : (CheckersColor::kDark);
+	if (m_position.CountPieces(m_currentPlayer) <= 0)
+		return GetOpponent(m_currentPlayer);
 
 	// other won
-	if (m_otherPieces.size() <= 0)
+	if (m_position.CountPieces(GetOpponent(m_currentPlayer)) <= 0)
 		return m_currentPlayer;
 
+	// Whoever has to move but can't loses
+	MoveList moves;
+	if (GetLegalMoves(moves) == 0)
+		return GetOpponent(m_position.m_sideToMove);
+
 	// Continue
 	return CheckersColor::kContinue;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-// Called whenever we get a tile select event. Returns selected tile index if it's valid, kInvalidIndex if not
-//      -mouseX: The X pixel position on the screen where the mouse clicked.
-//      -mouseY: The Y pixel position on the screen where the mouse clicked.
+// Reset all the pieces on map, both sides start over from the starting position
 //---------------------------------------------------------------------------------------------------------------------
-size_t GameState::OnSelected(Sint32 mouseX, Sint32 mouseY)
+void GameState::Restart()
 {
-	size_t index = GetIndexFromPixel(mouseX, mouseY);
-
-	// Get the piece on it
-	Piece* pSelectedPiece = m_tiles[index].GetPiece();
-
-	// if there is no piece on it, or it's not my piece, return invalid index
-	if (!pSelectedPiece || m_myPieces.find(index) == m_myPieces.end())
-		return kInvalidIndex;
-
-	// If we reach this point, means the selected piece is valid and is mine.
-	// Perform on selected behavior of this piece
-	pSelectedPiece->OnSelected();
-
-	// High light all possible moves
-	HighLightAllPossibleTiles(index);
-
-	return index;
+	m_position = Position::StartPosition();
+	m_hash = ComputeHash(m_position);
+	m_moveCount = 0;
+	m_undoStack.clear();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-// Called when the movement was invalid
-//		-tileIndex: The selected piece's tile index
+// Replace the whole game with the host's at once, so the winner is never judged on a half sent board
+//		-position: In the host's orientation, like ours
+//		-moveCount: Moves the host has played so far
 //---------------------------------------------------------------------------------------------------------------------
-void GameState::ResetSelectedPiece(size_t tileIndex)
+void GameState::ApplySnapshot(const Position& position, size_t moveCount)
 {
-	m_tiles[tileIndex].GetPiece()->UnSelect();
+	SetPosition(position);
+	m_moveCount = moveCount;
+	m_doneInit = true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-// Return if we have a valid move and the removing piece
-//		-fromIndex: The current tile index of the selected piece standing on
-//      -mouseX: The X pixel position on the screen where the mouse clicked.
-//      -mouseY: The Y pixel position on the screen where the mouse clicked.
+// Converts a tile index from this player's point of view to the board's, and back.
+// The client sees the board upside down, so its indices are reverted
 //---------------------------------------------------------------------------------------------------------------------
-MoveResult GameState::IsValidMove(Sint32 mouseX, Sint32 mouseY)
+size_t GameState::ToBoardIndex(size_t localIndex) const
 {
-	size_t destIndex = GetIndexFromPixel(mouseX, mouseY);
-	MoveResult result;
-
-	if (m_tiles[destIndex].HighLighted())
-	{
-		result.m_destIndex = destIndex;
-
-		// If we are killing anyone
-		if (m_pieceInDanger.find(destIndex) != m_pieceInDanger.end())
-			result.m_piecesToKill = m_pieceInDanger[destIndex];
-	}
-	return result;
+	return (m_currentPlayer == CheckersColor::kLight) ? RevertedIndex((int)localIndex) : localIndex;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-// Reset all the pieces on map
+// Play a whole move on the board: the piece, its path and every capture at once, then pass the turn
 //---------------------------------------------------------------------------------------------------------------------
-void GameState::Restart(SDL_Renderer* pRenderer)
+void GameState::PlayMove(const Move& move)
 {
-	// Delete all pieces
-	for (Tile& tile : m_tiles)
-		tile.RemovePiece();
-
-	InitMap(pRenderer, true);
+	Apply(move);
+	++m_moveCount;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-// Called when client initialize game board, client need the host to send all pieces info from here
-// This can be only called from Server
+// Set whose turn it is in the position, used when joining a game already going on
 //---------------------------------------------------------------------------------------------------------------------
-AllPiecesIndex GameState::GetAllPiecesIndex()
+void GameState::SetSideToMove(CheckersColor side)
 {
-	// Assert this is only called by the Dark/Host player
-	assert(m_currentPlayer == CheckersColor::kDark);
-
-	// Grab all the piece we want
-	AllPiecesIndex allPiecesInfo;
-	allPiecesInfo[(size_t)CheckersColor::kDark].reserve(m_myPieces.size());
-	allPiecesInfo[(size_t)CheckersColor::kLight].reserve(m_otherPieces.size());
-
-	// Get all dark pieces
-	for (size_t index : m_myPieces)
-		allPiecesInfo[(size_t)CheckersColor::kDark].emplace_back(index);
-
-	// All light pieces
-	for (size_t index : m_otherPieces)
-		allPiecesInfo[(size_t)CheckersColor::kLight].emplace_back(index);
-
-	return allPiecesInfo;
+	m_hash ^= GetSideKey(m_position.m_sideToMove) ^ GetSideKey(side);
+	m_position.m_sideToMove = side;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-// Place a Piece at index for the input side. This should be only called from Client
-//		-side: Indicates whose piece it is. 
-//		-index: Where to place it
-//		-pRenderer: I need this renderer to create the a piece
+// Replace the position, forgetting every move made so far
 //---------------------------------------------------------------------------------------------------------------------
-void GameState::PlacePiece(CheckersColor side, size_t index, SDL_Renderer* pRenderer)
+void GameState::SetPosition(const Position& position)
 {
-	assert(m_currentPlayer == CheckersColor::kLight);
-
-	// Place piece
-	m_tiles[index].SetPiece(new Piece(side, pRenderer));
-
-	// Insert index to pieces
-	if (side == m_currentPlayer)
-		m_myPieces.emplace(index);
-	else
-		m_otherPieces.emplace(index);
-
-	if (m_myPieces.size() > 0 && m_otherPieces.size() > 0)
-		m_doneInit = true;
+	m_position = position;
+	m_hash = ComputeHash(m_position);
+	m_moveCount = 0;
+	m_undoStack.clear();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-// Set up checker game map and pieces
-//		-pRenderer: Used when creating pieces
-//		-isRestarting: If we are restarting by the host's command
+// Fill moves with every legal move of the side to move, returns how many there are
 //---------------------------------------------------------------------------------------------------------------------
-void GameState::InitMap(SDL_Renderer* pRenderer, bool isRestarting)
+size_t GameState::GetLegalMoves(MoveList& moves) const
 {
-	bool isDarkCell = false;
-	size_t index = 0;
-
-	// Row
-	for (size_t row = 0; row < kBoardHeight; ++row)
-	{
-		// Col
-		for (size_t col = 0; col < kBoardWidth; ++col)
-		{
-			// Set tile's position
-			m_tiles[index].SetPosition(col, row);
-
-			// If it's a dark cell, I might wanna place pieces on them
-			if (isDarkCell)
-			{
-				// If it's a client, we want light pieces at bottom and dark pieces at top, and follow the host
-				if (m_currentPlayer == CheckersColor::kLight && isRestarting)
-				{
-					// Spawn dark piece
-					if (row < kSpawnTopPieceRow)
-					{
-						m_tiles[index].SetPiece(new Piece(CheckersColor::kDark, pRenderer));
-						m_otherPieces.emplace(index);
-					}
-					// Light
-					else if (row > kSpawnBottomPieceRow)
-					{
-						m_tiles[index].SetPiece(new Piece(CheckersColor::kLight, pRenderer));
-						m_myPieces.emplace(index);
-					}
-				}
-				// If it's a host, we want dark pieces at bottom and light pieces at top when Init
-				else if (m_currentPlayer == CheckersColor::kDark)
-				{
-#if TESTING
-
-#else
-					// Spawn light piece
-					if (row < kSpawnTopPieceRow)
-					{
-						m_tiles[index].SetPiece(new Piece(CheckersColor::kLight, pRenderer));
-						m_otherPieces.emplace(index);
-					}
-					else if (row > kSpawnBottomPieceRow)
-					{
-						m_tiles[index].SetPiece(new Piece(CheckersColor::kDark, pRenderer));
-						m_myPieces.emplace(index);
-					}
-#endif
-				}
-			}
-			else
-				m_tiles[index].SetSide(CheckersColor::kLight);
-
-			// Update bool flags
-			isDarkCell = !isDarkCell;
-			++index;
-		}
-		isDarkCell = !isDarkCell;
-	}
-#if TESTING
-	size_t lightPiece = 53;
-	size_t lightPiece2 = 35;
-	size_t lightPiece3 = 19;
-	size_t darkPiece = 62;
-
-	if (m_currentPlayer == CheckersColor::kDark)
-	{
-		m_tiles[lightPiece].SetPiece(new Piece(CheckersColor::kLight, pRenderer));
-		m_otherPieces.emplace(lightPiece);
-
-		m_tiles[lightPiece2].SetPiece(new Piece(CheckersColor::kLight, pRenderer));
-		m_otherPieces.emplace(lightPiece2);
-
-		m_tiles[lightPiece3].SetPiece(new Piece(CheckersColor::kLight, pRenderer));
-		m_otherPieces.emplace(lightPiece3);
-
-		m_tiles[darkPiece].SetPiece(new Piece(CheckersColor::kDark, pRenderer));
-		m_myPieces.emplace(darkPiece);
-	}
-#endif
+	return GenerateMoves(m_position, m_position.m_sideToMove, moves);
 }
 
-void GameState::HighLightAllPossibleTiles(size_t beginIndex)
+//---------------------------------------------------------------------------------------------------------------------
+// Play a legal move of the side to move, remembering how to take it back. Returns false if the undo stack is full
+//---------------------------------------------------------------------------------------------------------------------
+bool GameState::MakeMove(const Move& move)
 {
-	std::unordered_map<Pos, size_t> moveMap;
-	moveMap.insert({Pos::kLeftFwd, kInvalidIndex});
-	moveMap.insert({Pos::kRightFwd, kInvalidIndex});
-	moveMap.insert({Pos::kLeftBack, kInvalidIndex});
-	moveMap.insert({Pos::kRightBack, kInvalidIndex});
-
-	// High-light all possible, movable tiles for the selected piece
-	std::queue<size_t> startPoints;
-	startPoints.emplace(beginIndex);
-
-	while (!startPoints.empty())
-	{
-		size_t currentIndex = startPoints.front();
-		startPoints.pop();
-		Vector2 currPos = GetVec2FromIndex(currentIndex);
-
-		// Left Forward
-		ProcessHighLightTile((currPos.x - 1 >= 0 && currPos.y - 1 >= 0),	// Move condition
-			GetIndexFromPos((size_t)currPos.x - 1, (size_t)currPos.y - 1),	// Target index
-			(currPos.x - 2 >= 0 && currPos.y - 2 >= 0),						// Jump condition
-			GetIndexFromPos((size_t)currPos.x - 2, (size_t)currPos.y - 2),	// Jump index
-			moveMap,
-			currentIndex,
-			startPoints,
-			Pos::kLeftFwd);
+	assert(m_undoStack.size() < kMaxUndoDepth);
+	if (m_undoStack.size() >= kMaxUndoDepth)
+		return false;
 
-		// left backwards
-		ProcessHighLightTile((currPos.x - 1 >= 0 && currPos.y + 1 < kBoardHeight && m_tiles[beginIndex].GetPiece()->IsKing()),		// Move condition
-			GetIndexFromPos((size_t)currPos.x - 1, (size_t)currPos.y + 1),								// Target index
-			(currPos.x - 2 >= 0 && currPos.y + 2 < kBoardHeight && m_tiles[beginIndex].GetPiece()->IsKing()),		// Jump condition
-			GetIndexFromPos((size_t)currPos.x - 2, (size_t)currPos.y + 2),								// Jump index
-			moveMap,
-			currentIndex,
-			startPoints,
-			Pos::kLeftBack);
-
-		// Right Forward
-		ProcessHighLightTile((currPos.x + 1 < kBoardWidth && currPos.y - 1 >= 0),						// Move condition
-			GetIndexFromPos((size_t)currPos.x + 1, (size_t)currPos.y - 1),	// Target index
-			(currPos.x + 2 < kBoardWidth && currPos.y - 2 >= 0),						// Jump condition
-			GetIndexFromPos((size_t)currPos.x + 2, (size_t)currPos.y - 2),	// Jump index
-			moveMap,
-			currentIndex,
-			startPoints,
-			Pos::kRightFwd);
-
-		// Right backwards
-		ProcessHighLightTile((currPos.x + 1 < kBoardWidth && currPos.y + 1 < kBoardHeight && m_tiles[beginIndex].GetPiece()->IsKing()),						// Move condition
-			GetIndexFromPos((size_t)currPos.x + 1, (size_t)currPos.y + 1),	// Target index
-			(currPos.x + 2 < kBoardWidth && currPos.y + 2 < kBoardHeight && m_tiles[beginIndex].GetPiece()->IsKing()),						// Jump condition
-			GetIndexFromPos((size_t)currPos.x + 2, (size_t)currPos.y + 2),	// Jump index
-			moveMap,
-			currentIndex,
-			startPoints,
-			Pos::kRightBack);
-	}
-
-	// If there is no hop, set movable tiles highlighted
-	if (m_pieceInDanger.empty())
-	{
-		for (auto& [pos, index] : moveMap)
-		{
-			if (index != kInvalidIndex)
-				m_tiles[index].SetHighLighted();
-		}
-	}
+	Undo& undo = m_undoStack.emplace_back();
+	undo.m_move = move;
+	undo.m_capturedKings = move.m_captured & m_position.m_kings;
+	undo.m_hash = m_hash;
+	undo.m_isCrowned = Apply(move);
+	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-// Return if the index is in m_pieceInDanger's value
+// Play move on the position and the hash together. Returns true if it crowned the piece
 //---------------------------------------------------------------------------------------------------------------------
-bool GameState::IsInDanger(size_t index) const
+bool GameState::Apply(const Move& move)
 {
-	for (const auto& [key, inDangerVec] : m_pieceInDanger)
-	{
-		for (size_t inDangerIndex : inDangerVec)
-		{
-			if (inDangerIndex == index)
-				return true;
-		}
-	}
-	return false;
-}
+	// Take the captured pieces and the mover off the hash before the board changes
+	CheckersColor mover = m_position.m_sideToMove;
+	CheckersColor opponent = GetOpponent(mover);
+	bool wasKing = m_position.IsKing(move.From());
 
-void GameState::ProcessHighLightTile(bool moveCondition, size_t targetTileIndex, bool jumpCondition, size_t jumpIndex, std::unordered_map<Pos, size_t>& moveMap, size_t currentIndex, std::queue<size_t>& startPoints, Pos dir)
-{
-	// Move
-	if (moveCondition && !m_tiles[targetTileIndex].GetPiece())
+	Bitboard captured = move.m_captured;
+	while (captured)
 	{
-		moveMap[dir] = targetTileIndex;
+		size_t square = PopLowestSquare(captured);
+		m_hash ^= GetPieceKey(opponent, square, m_position.IsKing(square));
 	}
-	// Jump
-	if (jumpCondition && !m_tiles[jumpIndex].GetPiece() && 	// There is a spot for me to jump
-		m_tiles[targetTileIndex].GetPiece() && m_tiles[targetTileIndex].GetPiece()->GetCheckerColor() != m_currentPlayer &&
-		!IsInDanger(targetTileIndex))	// There is a piece on the dest tile that is not mine
-	{
-		// High-light jump spot 
-		m_tiles[jumpIndex].SetHighLighted();
 
-		// Mark that jumpped over piece in danger
-		m_pieceInDanger[jumpIndex].emplace_back(targetTileIndex);
+	bool isCrowned = ApplyMove(m_position, move);
+	m_hash ^= GetPieceKey(mover, move.From(), wasKing) ^ GetPieceKey(mover, move.Dest(), wasKing || isCrowned);
+	m_hash ^= GetSideKey(mover) ^ GetSideKey(opponent);
 
-		// Multiple hop
-		if (m_pieceInDanger.find(currentIndex) != m_pieceInDanger.end())
-		{
-			m_tiles[currentIndex].Reset();
-			for (size_t index : m_pieceInDanger[currentIndex])
-				m_pieceInDanger[jumpIndex].emplace_back(index);
-			m_pieceInDanger.erase(currentIndex);
-		}
-
-		startPoints.emplace(jumpIndex);
-	}
+	assert(m_hash == ComputeHash(m_position));
+	return isCrowned;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-// Reset high-lighted tiles
+// Take back the last move made with MakeMove: bring the piece home, uncrown it, and put the captured pieces back
 //---------------------------------------------------------------------------------------------------------------------
-void GameState::ResetHighlightedTiles()
+void GameState::UnmakeMove()
 {
-	for (Tile& tile : m_tiles)
-		tile.Reset();
-	m_pieceInDanger.clear();
-}
+	assert(!m_undoStack.empty());
 
-//---------------------------------------------------------------------------------------------------------------------
-// Remove a piece at index, update pieces recording sets
-//---------------------------------------------------------------------------------------------------------------------
-void GameState::KillPieceAt(size_t index)
-{
-	m_tiles[index].RemovePiece();
-
-	if (m_myPieces.find(index) != m_myPieces.end())
-		m_myPieces.erase(index);
-	else if (m_otherPieces.find(index) != m_otherPieces.end())
-		m_otherPieces.erase(index);
-}
+	const Undo& undo = m_undoStack.back();
+	const Move& move = undo.m_move;
 
-//---------------------------------------------------------------------------------------------------------------------
-// Move fromIndex's tile's m_pPiece destIndex's tile's m_pPiece, update m_myPieces if it's a local made movement
-//---------------------------------------------------------------------------------------------------------------------
-void GameState::MovePiece(size_t fromIndex, size_t destIndex)
-{
-	m_tiles[destIndex].SetPiece(m_tiles[fromIndex].GetPiece());
-	m_tiles[fromIndex].SetPiece(nullptr);
+	// The turn goes back to whoever made the move
+	CheckersColor mover = GetOpponent(m_position.m_sideToMove);
+	m_position.m_sideToMove = mover;
 
-	// If this move is made by myself, update my pieces index
-	if (m_myPieces.find(fromIndex) != m_myPieces.end())
-	{
-		m_myPieces.erase(fromIndex);
-		m_myPieces.emplace(destIndex);
-	}
-	// If this move is made by the opponent, update m_otherPieces
-	else if(m_otherPieces.find(fromIndex) != m_otherPieces.end())
-	{
-		m_otherPieces.erase(fromIndex);
-		m_otherPieces.emplace(destIndex);
-	}
+	bool isKing = m_position.IsKing(move.Dest()) && !undo.m_isCrowned;
+	m_position.Remove(move.Dest());
+	m_position.Place(mover, move.From(), isKing);
 
-	// If dest is at the other's bottom, upgrade that piece to king
-	if (destIndex / kBoardWidth == 0 && m_myPieces.find(destIndex) != m_myPieces.end())
-		m_tiles[destIndex].GetPiece()->ToKing();
+	m_position.m_pieces[(size_t)GetOpponent(mover)] |= move.m_captured;
+	m_position.m_kings |= undo.m_capturedKings;
+	m_hash = undo.m_hash;
+	m_undoStack.pop_back();
 }
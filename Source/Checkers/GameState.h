@@ -1,65 +1,65 @@
 #pragma once
 
-#include "Tile.h"
+#include "Position.h"
+#include "MoveGenerator.h"
+#include "Zobrist.h"
 #include "Checkers/CheckersConstants.h"
-#include "Utils/Math/Vector2.h"
 
-#include <unordered_set>
-#include <unordered_map>
-#include <SDL.h>
-#include <queue>
+#include <vector>
 
 //--------------------------------------------------------------------------------------------------------------
-// Represents Checkers game state
+// Represents Checkers game state. Rules only, CheckersBoard draws it
 //--------------------------------------------------------------------------------------------------------------
 class GameState
 {
-	enum class Pos
+	// Constants
+	static constexpr size_t kMaxUndoDepth = 256;	// How many moves MakeMove can stack up before they must be unmade
+
+	// Everything UnmakeMove needs to take a move back
+	struct Undo
 	{
-		kLeftFwd,
-		kRightFwd,
-		kLeftBack,
-		kRightBack,
+		Move m_move;
+		Bitboard m_capturedKings;	// Which of the captured pieces were kings
+		bool m_isCrowned;			// If the move crowned the piece
+		ZobristKey m_hash;			// Hash before the move
 	};
 
-	// Constants
-	static constexpr size_t kSpawnBottomPieceRow = 4;
-	static constexpr size_t kSpawnTopPieceRow = 3;
-
-	// Game map array
-	Tile m_tiles[kBoardSize];	
+	// Source of truth for every piece on the board, in the host's orientation
+	Position m_position;
+	ZobristKey m_hash;		// Kept in step with m_position by every change made through GameState
+	size_t m_moveCount;		// Moves played on the board since the game started, search moves don't count
 
 	// Used for tracking winners
 	CheckersColor m_currentPlayer;
 	bool m_doneInit;
 
-	// Store pieces index
-	std::unordered_set<size_t> m_myPieces;
-	std::unordered_set<size_t> m_otherPieces;
-	std::unordered_map<size_t, std::vector<size_t>> m_pieceInDanger;	// For removing other's piece when jump occurs, first size_t for storing the destination tile index, second size_t for storing the other's piece in danger
+	// Moves made with MakeMove, newest last. Empty until something searches this state, then it keeps its
+	// capacity, so a board that's only played on stays the position plus its hash
+	std::vector<Undo> m_undoStack;
 
 public:
 	GameState();
 
-	void Init(SDL_Renderer* pRenderer, bool isClient);
-	void Render(SDL_Renderer* pRenderer) const;
-
-	void MovePiece(size_t fromIndex, size_t destIndex);
-	void KillPieceAt(size_t index);
-	void ResetSelectedPiece(size_t tileIndex);
-	void ResetHighlightedTiles();
-	void Restart(SDL_Renderer* pRenderer);
-	void PlacePiece(CheckersColor side, size_t index, SDL_Renderer* pRenderer);
-	size_t OnSelected(Sint32 mouseX, Sint32 mouseY);
-	MoveResult IsValidMove(Sint32 mouseX, Sint32 mouseY);
+	void Init(bool isClient);
+	void PlayMove(const Move& move);
+	void Restart();
+	void ApplySnapshot(const Position& position, size_t moveCount);
 	CheckersColor CheckerWinner() const;
 	CheckersColor GetPlayer() const { return m_currentPlayer; }
-	AllPiecesIndex GetAllPiecesIndex();
+	void SetPlayer(CheckersColor player) { m_currentPlayer = player; }		// A lobby may seat a client on either side
+	const Position& GetPosition() const { return m_position; }
+	ZobristKey GetHash() const { return m_hash; }
+	size_t GetMoveCount() const { return m_moveCount; }
+	void SetSideToMove(CheckersColor side);
+	size_t ToBoardIndex(size_t localIndex) const;
+
+	// Reversible moves for searching, validating and replaying
+	void SetPosition(const Position& position);
+	size_t GetLegalMoves(MoveList& moves) const;
+	bool MakeMove(const Move& move);
+	void UnmakeMove();
+	size_t GetUndoCount() const { return m_undoStack.size(); }
 
 private:
-	void InitMap(SDL_Renderer* pRenderer, bool isRestarting);
-	void HighLightAllPossibleTiles(size_t beginIndex);
-	bool IsInDanger(size_t index) const;
-	void ProcessHighLightTile(bool moveCondition, size_t targetTileIndex, bool jumpCondition, size_t jumpIndex, std::unordered_map<Pos, size_t>& moveMap, size_t currentIndex, std::queue<size_t>& startPoints, Pos dir);
+	bool Apply(const Move& move);
 };
-
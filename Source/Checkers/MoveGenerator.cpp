@@ -0,0 +1,239 @@
+#include "MoveGenerator.h"
+
+#include <algorithm>
+#include <assert.h>
+
+//---------------------------------------------------------------------------------------------------------------------
+// Squares shift by a different amount depending on their row, one step covers each half of the board's rows
+//---------------------------------------------------------------------------------------------------------------------
+struct Step
+{
+	Bitboard m_from = 0;	// Squares that can take this step without leaving the board
+	int m_delta = 0;		// How far the square number moves
+};
+
+static constexpr Step GetStep(Direction dir, size_t rowParity)
+{
+	Step step;
+	for (size_t square = 0; square < kSquareCount; ++square)
+	{
+		size_t neighbor = kNeighborSquare[square][(size_t)dir];
+		if ((square / kSquaresPerRow) % 2 != rowParity || neighbor == kSquareCount)
+			continue;
+
+		step.m_from |= GetSquareMask(square);
+		step.m_delta = (int)neighbor - (int)square;
+	}
+	return step;
+}
+
+static constexpr Step kSteps[(size_t)Direction::kCount][2] =
+{
+	{ GetStep(Direction::kUpLeft, 0), GetStep(Direction::kUpLeft, 1) },
+	{ GetStep(Direction::kUpRight, 0), GetStep(Direction::kUpRight, 1) },
+	{ GetStep(Direction::kDownLeft, 0), GetStep(Direction::kDownLeft, 1) },
+	{ GetStep(Direction::kDownRight, 0), GetStep(Direction::kDownRight, 1) },
+};
+
+static constexpr Bitboard Shift(Bitboard bitboard, int delta)
+{
+	return (delta > 0) ? (bitboard << delta) : (bitboard >> -delta);
+}
+
+// Returns every square in bitboard moved one step toward dir, squares that would leave the board are dropped
+static constexpr Bitboard ShiftBitboard(Bitboard bitboard, Direction dir)
+{
+	const Step& even = kSteps[(size_t)dir][0];
+	const Step& odd = kSteps[(size_t)dir][1];
+	return Shift(bitboard & even.m_from, even.m_delta) | Shift(bitboard & odd.m_from, odd.m_delta);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Men only go forward, kings go both ways
+//---------------------------------------------------------------------------------------------------------------------
+static constexpr Direction kDirections[(size_t)Direction::kCount] = { Direction::kUpLeft, Direction::kUpRight, Direction::kDownLeft, Direction::kDownRight };
+
+static bool CanGo(CheckersColor side, bool isKing, Direction dir)
+{
+	if (isKing)
+		return true;
+
+	bool isUp = (dir == Direction::kUpLeft || dir == Direction::kUpRight);
+	return isUp == (side == CheckersColor::kDark);
+}
+
+static Bitboard GetPromotionRow(CheckersColor side)
+{
+	return (side == CheckersColor::kDark) ? kTopRow : kBottomRow;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Append a move to the list, ignoring it if the list is somehow full
+//---------------------------------------------------------------------------------------------------------------------
+static void AddMove(MoveList& moves, const Move& move)
+{
+	assert(moves.m_count < kMaxMoves);
+	if (moves.m_count < kMaxMoves)
+		moves.m_moves[moves.m_count++] = move;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Depth first search of every jump sequence continuing from the last square of move.
+// Jumped pieces stay on the board until the move is over, so they can't be jumped twice or landed on
+//		-empty: Empty squares, including the square the jumping piece started from
+//		-opponents: The other side's pieces
+//---------------------------------------------------------------------------------------------------------------------
+static void AddJumps(CheckersColor side, bool isKing, Bitboard empty, Bitboard opponents, Move& move, MoveList& moves)
+{
+	size_t square = move.Dest();
+	bool hasJumped = false;
+
+	for (Direction dir : kDirections)
+	{
+		if (!CanGo(side, isKing, dir))
+			continue;
+
+		// The jump table is off the board whenever the neighbor is
+		size_t landSquare = kJumpSquare[square][(size_t)dir];
+		if (landSquare == kSquareCount)
+			continue;
+
+		size_t overSquare = kNeighborSquare[square][(size_t)dir];
+
+		Bitboard overMask = GetSquareMask(overSquare);
+		Bitboard landMask = GetSquareMask(landSquare);
+		if (!(opponents & overMask) || (move.m_captured & overMask) || !(empty & landMask))
+			continue;
+
+		hasJumped = true;
+		move.m_captured |= overMask;
+		move.m_path[move.m_pathLength++] = (uint8_t)landSquare;
+
+		// A man that reaches the far row is crowned and its move ends there
+		if (!isKing && (landMask & GetPromotionRow(side)))
+			AddMove(moves, move);
+		else
+			AddJumps(side, isKing, empty, opponents, move, moves);
+
+		--move.m_pathLength;
+		move.m_captured &= ~overMask;
+	}
+
+	// Nowhere left to jump, this sequence is a complete move
+	if (!hasJumped && move.IsCapture())
+		AddMove(moves, move);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns true if any of pieces can jump one of opponents
+//---------------------------------------------------------------------------------------------------------------------
+static bool HasJump(CheckersColor side, Bitboard men, Bitboard kings, Bitboard empty, Bitboard opponents)
+{
+	for (Direction dir : kDirections)
+	{
+		Bitboard movers = CanGo(side, false, dir) ? (men | kings) : kings;
+		if (ShiftBitboard(ShiftBitboard(movers, dir) & opponents, dir) & empty)
+			return true;
+	}
+	return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Fill moves with every legal move of side in position, returns how many there are
+//		-position: The position to generate moves for
+//		-side: Whose moves, doesn't have to be position's side to move
+//		-moves: Where to write the moves, cleared first
+//---------------------------------------------------------------------------------------------------------------------
+size_t GenerateMoves(const Position& position, CheckersColor side, MoveList& moves)
+{
+	moves.Clear();
+
+	Bitboard pieces = position.m_pieces[(size_t)side];
+	Bitboard opponents = position.m_pieces[(size_t)GetOpponent(side)];
+	Bitboard kings = pieces & position.m_kings;
+	Bitboard men = pieces & ~position.m_kings;
+	Bitboard empty = position.Empty();
+
+	// Jumps are mandatory, and every piece able to jump must keep going
+	if (HasJump(side, men, kings, empty, opponents))
+	{
+		Bitboard jumpers = pieces;
+		while (jumpers)
+		{
+			size_t square = PopLowestSquare(jumpers);
+
+			Move move;
+			move.m_path[move.m_pathLength++] = (uint8_t)square;
+			AddJumps(side, position.IsKing(square), empty | GetSquareMask(square), opponents, move, moves);
+		}
+		return moves.m_count;
+	}
+
+	// Single steps onto an empty square
+	for (Direction dir : kDirections)
+	{
+		Bitboard movers = CanGo(side, false, dir) ? pieces : kings;
+		for (const Step& step : kSteps[(size_t)dir])
+		{
+			Bitboard dests = Shift(movers & step.m_from, step.m_delta) & empty;
+			while (dests)
+			{
+				size_t destSquare = PopLowestSquare(dests);
+
+				Move move;
+				move.m_path[0] = (uint8_t)(destSquare - step.m_delta);
+				move.m_path[1] = (uint8_t)destSquare;
+				move.m_pathLength = 2;
+				AddMove(moves, move);
+			}
+		}
+	}
+	return moves.m_count;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Play move on position: remove the captured pieces, move and maybe crown the piece, then pass the turn.
+// Returns true if the piece was crowned
+//---------------------------------------------------------------------------------------------------------------------
+bool ApplyMove(Position& position, const Move& move)
+{
+	Bitboard captured = move.m_captured;
+	position.m_pieces[(size_t)CheckersColor::kDark] &= ~captured;
+	position.m_pieces[(size_t)CheckersColor::kLight] &= ~captured;
+	position.m_kings &= ~captured;
+
+	bool isCrowned = position.Move(move.From(), move.Dest());
+	position.m_sideToMove = GetOpponent(position.m_sideToMove);
+	return isCrowned;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns true if move is one of the legal moves of the side to move. Jumps with the same ends can take different
+// paths, so every square of the path has to match, and the captures with it
+//---------------------------------------------------------------------------------------------------------------------
+bool IsLegalMove(const Position& position, const Move& move)
+{
+	MoveList moves;
+	GenerateMoves(position, position.m_sideToMove, moves);
+	for (const Move& legalMove : moves)
+	{
+		if (legalMove.m_captured == move.m_captured && legalMove.m_pathLength == move.m_pathLength
+			&& std::equal(move.m_path, move.m_path + move.m_pathLength, legalMove.m_path))
+			return true;
+	}
+	return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns move in checkers notation, "11-15" for a step and "15x24x31" for a jump
+//---------------------------------------------------------------------------------------------------------------------
+std::string MoveToString(const Move& move)
+{
+	std::string text = std::to_string(GetNotationFromSquare(move.From()));
+	for (size_t i = 1; i < move.m_pathLength; ++i)
+	{
+		text += move.IsCapture() ? "x" : "-";
+		text += std::to_string(GetNotationFromSquare(move.m_path[i]));
+	}
+	return text;
+}
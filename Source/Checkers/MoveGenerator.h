@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Position.h"
+#include "CheckersConstants.h"
+
+#include <cstdint>
+#include <string>
+
+//--------------------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------------------
+static constexpr size_t kMaxCaptures = 12;		// A side can't lose more pieces than it starts with
+static constexpr size_t kMaxMoves = 128;		// Upper bound of legal moves in any reachable position
+
+//--------------------------------------------------------------------------------------------------------------
+// A single legal move. Multi-jumps keep every square the piece lands on, so two paths with the same ends are different moves
+//--------------------------------------------------------------------------------------------------------------
+struct Move
+{
+	Bitboard m_captured = 0;						// Squares of the opponent's pieces jumped over
+	uint8_t m_path[kMaxCaptures + 1] = {};			// Squares the piece stands on, from where it starts to where it stops
+	uint8_t m_pathLength = 0;
+
+	size_t From() const { return m_path[0]; }
+	size_t Dest() const { return m_path[m_pathLength - 1]; }
+	bool IsCapture() const { return m_captured != 0; }
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Fixed size list of moves, lives on the stack so generating moves never allocates
+//--------------------------------------------------------------------------------------------------------------
+struct MoveList
+{
+	Move m_moves[kMaxMoves];
+	size_t m_count = 0;
+
+	void Clear() { m_count = 0; }
+	size_t Size() const { return m_count; }
+	bool Empty() const { return m_count == 0; }
+	Move& operator[](size_t index) { return m_moves[index]; }
+	const Move& operator[](size_t index) const { return m_moves[index]; }
+	Move* begin() { return m_moves; }
+	Move* end() { return m_moves + m_count; }
+	const Move* begin() const { return m_moves; }
+	const Move* end() const { return m_moves + m_count; }
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Move generation
+//--------------------------------------------------------------------------------------------------------------
+// Fill moves with every legal move of side in position, returns how many there are.
+// Captures are mandatory: if side can jump, only jumps are returned, each one continued until the piece can't jump any more
+size_t GenerateMoves(const Position& position, CheckersColor side, MoveList& moves);
+
+// Play move on position: remove the captured pieces, move and maybe crown the piece, then pass the turn. Returns true if it crowned
+bool ApplyMove(Position& position, const Move& move);
+
+// Returns true if move is one of the legal moves of the side to move, the same path and the same captures
+bool IsLegalMove(const Position& position, const Move& move);
+
+// Returns move in checkers notation, "11-15" for a step and "15x24x31" for a jump
+std::string MoveToString(const Move& move);
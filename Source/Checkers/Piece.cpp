@@ -13,7 +13,6 @@
 Piece::Piece(CheckersColor side, SDL_Renderer* pRenderer)
 	: m_color{ side }
     , m_pTexture{ nullptr }
-    , m_isKing{ false }
 {
     // SDL rect
     m_pieceRect.w = kTileWidth - 1;
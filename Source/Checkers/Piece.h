@@ -14,9 +14,8 @@ private:
 	static constexpr SDL_Color kLightTileColor = { 225,225,225,1 };
 	static constexpr int kOnSelectedYOffset = kTileHeight / 3;
 
-	// Gameplay
+	// Which sprite to draw, the game rules live in GameState's Position
 	CheckersColor m_color;
-	bool m_isKing;
 
 	// Drawing
 	SDL_Rect m_pieceRect;
@@ -33,8 +32,6 @@ public:
 	void OnSelected();
 	void UnSelect();
 	void SetPosition(SDL_Rect transform) { m_pieceRect = transform; }
-	void ToKing() { m_isKing = true; }
-	bool IsKing() const { return m_isKing; }
 	CheckersColor GetCheckerColor() const { return m_color; }
 };
 
@@ -0,0 +1,208 @@
+#include "Position.h"
+
+#include <assert.h>
+#include <ctype.h>
+
+Position::Position()
+	: m_pieces{ 0, 0 }
+	, m_kings{ 0 }
+	, m_sideToMove{ CheckersColor::kDark }
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns the position every game begins with, light pieces fill the top three rows and dark pieces the bottom three
+//---------------------------------------------------------------------------------------------------------------------
+Position Position::StartPosition()
+{
+	Position position;
+	position.m_pieces[(size_t)CheckersColor::kLight] = 0x00000FFF;
+	position.m_pieces[(size_t)CheckersColor::kDark] = 0xFFF00000;
+	return position;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Remove every piece, dark to move
+//---------------------------------------------------------------------------------------------------------------------
+void Position::Clear()
+{
+	*this = Position();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Put a piece on an empty square
+//		-side: Whose piece it is
+//		-square: Where to place it
+//		-isKing: If the piece is already crowned
+//---------------------------------------------------------------------------------------------------------------------
+void Position::Place(CheckersColor side, size_t square, bool isKing)
+{
+	assert(square < kSquareCount && IsEmpty(square));
+
+	m_pieces[(size_t)side] |= GetSquareMask(square);
+	if (isKing)
+		m_kings |= GetSquareMask(square);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Take whatever piece stands on square off the board
+//---------------------------------------------------------------------------------------------------------------------
+void Position::Remove(size_t square)
+{
+	assert(square < kSquareCount);
+
+	Bitboard keep = ~GetSquareMask(square);
+	m_pieces[(size_t)CheckersColor::kDark] &= keep;
+	m_pieces[(size_t)CheckersColor::kLight] &= keep;
+	m_kings &= keep;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Relocate the piece on fromSquare to destSquare, crowning it if it reached the far row. Returns true if it was crowned
+//---------------------------------------------------------------------------------------------------------------------
+bool Position::Move(size_t fromSquare, size_t destSquare)
+{
+	assert(fromSquare < kSquareCount && destSquare < kSquareCount);
+
+	// A king can jump in a loop back to where it started
+	if (fromSquare == destSquare)
+		return false;
+
+	Bitboard fromMask = GetSquareMask(fromSquare);
+	Bitboard destMask = GetSquareMask(destSquare);
+	Bitboard bothMask = fromMask | destMask;
+
+	// Find the mover's side
+	size_t side = (m_pieces[(size_t)CheckersColor::kDark] & fromMask) ? (size_t)CheckersColor::kDark : (size_t)CheckersColor::kLight;
+	assert(m_pieces[side] & fromMask);
+
+	m_pieces[side] ^= bothMask;
+	if (m_kings & fromMask)
+	{
+		m_kings ^= bothMask;
+		return false;
+	}
+
+	// Men become kings on the opponent's back row
+	Bitboard promotionRow = (side == (size_t)CheckersColor::kDark) ? kTopRow : kBottomRow;
+	if (destMask & promotionRow)
+	{
+		m_kings |= destMask;
+		return true;
+	}
+	return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Parse a position from checkers FEN, e.g. "B:W18,24,27,28,K10,K15:B12,16,20,K22,K25,K29". Returns false if it's malformed
+// Dark plays black (B), light plays white (W). Square ranges such as "B1-12" are accepted
+//		-fen: The text to parse
+//		-position: Receives the position, left untouched on failure
+//---------------------------------------------------------------------------------------------------------------------
+bool Position::FromFen(const std::string& fen, Position& position)
+{
+	Position parsed;
+	size_t cursor = 0;
+
+	auto parseColor = [&fen, &cursor](CheckersColor& side) -> bool
+	{
+		if (cursor >= fen.size())
+			return false;
+
+		char color = (char)toupper(fen[cursor++]);
+		if (color != 'B' && color != 'W')
+			return false;
+
+		side = (color == 'B') ? CheckersColor::kDark : CheckersColor::kLight;
+		return true;
+	};
+
+	auto parseNumber = [&fen, &cursor](size_t& number) -> bool
+	{
+		size_t begin = cursor;
+		number = 0;
+		while (cursor < fen.size() && isdigit((unsigned char)fen[cursor]))
+			number = number * 10 + (size_t)(fen[cursor++] - '0');
+		return cursor != begin;
+	};
+
+	// Side to move
+	if (!parseColor(parsed.m_sideToMove))
+		return false;
+
+	// One ":<color><squares>" section per side
+	while (cursor < fen.size() && fen[cursor] == ':')
+	{
+		++cursor;
+
+		CheckersColor side;
+		if (!parseColor(side))
+			return false;
+
+		while (cursor < fen.size() && fen[cursor] != ':' && fen[cursor] != '.')
+		{
+			bool isKing = (toupper(fen[cursor]) == 'K');
+			if (isKing)
+				++cursor;
+
+			size_t first = 0;
+			if (!parseNumber(first))
+				return false;
+
+			size_t last = first;
+			if (cursor < fen.size() && fen[cursor] == '-')
+			{
+				++cursor;
+				if (!parseNumber(last))
+					return false;
+			}
+
+			for (size_t notation = first; notation <= last; ++notation)
+			{
+				size_t square = GetSquareFromNotation(notation);
+				if (square == kSquareCount || !parsed.IsEmpty(square))
+					return false;
+				parsed.Place(side, square, isKing);
+			}
+
+			if (cursor < fen.size() && fen[cursor] == ',')
+				++cursor;
+		}
+	}
+
+	if (cursor < fen.size() && fen[cursor] != '.')
+		return false;
+
+	position = parsed;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns this position as checkers FEN, the inverse of FromFen
+//---------------------------------------------------------------------------------------------------------------------
+std::string Position::ToFen() const
+{
+	std::string fen = (m_sideToMove == CheckersColor::kDark) ? "B" : "W";
+
+	for (CheckersColor side : { CheckersColor::kLight, CheckersColor::kDark })
+	{
+		fen += (side == CheckersColor::kDark) ? ":B" : ":W";
+
+		// Notation counts the other way from squares
+		bool isFirst = true;
+		for (size_t notation = 1; notation <= kSquareCount; ++notation)
+		{
+			size_t square = GetSquareFromNotation(notation);
+			if (!HasPiece(side, square))
+				continue;
+
+			if (!isFirst)
+				fen += ",";
+			if (IsKing(square))
+				fen += "K";
+			fen += std::to_string(notation);
+			isFirst = false;
+		}
+	}
+	return fen;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "CheckersConstants.h"
+
+#include <bit>
+#include <cstdint>
+#include <string>
+
+//--------------------------------------------------------------------------------------------------------------
+// Bitboard constants
+//--------------------------------------------------------------------------------------------------------------
+// One bit per playable (dark) tile. Square 0 is the first dark tile of the top row, square 31 the last dark tile of the bottom row
+using Bitboard = uint32_t;
+
+static constexpr size_t kSquaresPerRow = kBoardWidth / 2;
+static constexpr size_t kSquareCount = kBoardSize / 2;
+static constexpr Bitboard kAllSquares = 0xFFFFFFFF;
+static constexpr Bitboard kTopRow = 0x0000000F;			// Dark pieces promote here
+static constexpr Bitboard kBottomRow = 0xF0000000;		// Light pieces promote here
+
+//--------------------------------------------------------------------------------------------------------------
+// Bitboard helper functions
+//--------------------------------------------------------------------------------------------------------------
+// Return the bit of a square
+constexpr Bitboard GetSquareMask(size_t square)
+{
+	return Bitboard(1) << square;
+}
+
+// Return true if a piece can stand on the tile at index
+constexpr bool IsPlayableIndex(size_t index)
+{
+	return index < kBoardSize && ((index / kBoardWidth) + (index % kBoardWidth)) % 2 == 1;
+}
+
+// Return the square of a playable tile index
+constexpr size_t GetSquareFromIndex(size_t index)
+{
+	return index / 2;
+}
+
+// Return the tile index of a square
+constexpr size_t GetIndexFromSquare(size_t square)
+{
+	size_t row = square / kSquaresPerRow;
+	size_t col = (square % kSquaresPerRow) * 2 + ((row % 2 == 0) ? 1 : 0);
+	return GetIndexFromPos(col, row);
+}
+
+// Return the lowest square in a bitboard, and remove it from the bitboard
+inline size_t PopLowestSquare(Bitboard& bitboard)
+{
+	size_t square = (size_t)std::countr_zero(bitboard);
+	bitboard &= bitboard - 1;
+	return square;
+}
+
+// Return the square number used by checkers notation and FEN: 1 to 32, counting from dark's back row since dark plays black
+constexpr size_t GetNotationFromSquare(size_t square)
+{
+	return kSquareCount - square;
+}
+
+// Return the square of a checkers notation number, kSquareCount if it's out of range
+constexpr size_t GetSquareFromNotation(size_t notation)
+{
+	return (notation >= 1 && notation <= kSquareCount) ? kSquareCount - notation : kSquareCount;
+}
+
+// Return the other side
+constexpr CheckersColor GetOpponent(CheckersColor side)
+{
+	return (side == CheckersColor::kDark) ? CheckersColor::kLight : CheckersColor::kDark;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Lookup tables, the square versions of kNeighborIndex and kJumpIndex. kSquareCount off the board
+//--------------------------------------------------------------------------------------------------------------
+using SquareTable = std::array<std::array<uint8_t, (size_t)Direction::kCount>, kSquareCount>;
+
+constexpr SquareTable BuildSquareTable(const DiagonalTable& indexTable)
+{
+	SquareTable table{};
+	for (size_t square = 0; square < kSquareCount; ++square)
+	{
+		for (size_t dir = 0; dir < (size_t)Direction::kCount; ++dir)
+		{
+			size_t index = indexTable[GetIndexFromSquare(square)][dir];
+			table[square][dir] = (uint8_t)((index == kInvalidIndex) ? kSquareCount : GetSquareFromIndex(index));
+		}
+	}
+	return table;
+}
+
+static constexpr SquareTable kNeighborSquare = BuildSquareTable(kNeighborIndex);
+static constexpr SquareTable kJumpSquare = BuildSquareTable(kJumpIndex);
+
+//--------------------------------------------------------------------------------------------------------------
+// Compact checkers position, always stored in the host's orientation: dark pieces start at the bottom and move up
+//--------------------------------------------------------------------------------------------------------------
+struct Position
+{
+	Bitboard m_pieces[(size_t)CheckersColor::kCount];	// Occupied squares of each side
+	Bitboard m_kings;									// Which occupied squares hold a king, for both sides
+	CheckersColor m_sideToMove;
+
+	Position();
+
+	static Position StartPosition();
+	static bool FromFen(const std::string& fen, Position& position);
+	std::string ToFen() const;
+
+	void Clear();
+	void Place(CheckersColor side, size_t square, bool isKing);
+	void Remove(size_t square);
+	bool Move(size_t fromSquare, size_t destSquare);
+
+	Bitboard Occupied() const { return m_pieces[(size_t)CheckersColor::kDark] | m_pieces[(size_t)CheckersColor::kLight]; }
+	Bitboard Empty() const { return ~Occupied(); }
+	bool HasPiece(CheckersColor side, size_t square) const { return (m_pieces[(size_t)side] & GetSquareMask(square)) != 0; }
+	bool IsEmpty(size_t square) const { return (Occupied() & GetSquareMask(square)) == 0; }
+	bool IsKing(size_t square) const { return (m_kings & GetSquareMask(square)) != 0; }
+	size_t CountPieces(CheckersColor side) const { return (size_t)std::popcount(m_pieces[(size_t)side]); }
+
+	bool operator==(const Position& other) const = default;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Position.h"
+#include "CheckersConstants.h"
+
+#include <cstdint>
+
+//--------------------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------------------
+// 64 bit key identifying a position, XOR of one random key per piece on the board and one for light to move
+using ZobristKey = uint64_t;
+
+static constexpr uint64_t kZobristSeed = 0x9E3779B97F4A7C15ULL;	// Changing it changes every hash, including saved ones
+
+//--------------------------------------------------------------------------------------------------------------
+// Random keys, generated at compile time so every build and both ends of a connection agree on them
+//--------------------------------------------------------------------------------------------------------------
+struct ZobristTable
+{
+	ZobristKey m_men[(size_t)CheckersColor::kCount][kSquareCount];
+	ZobristKey m_kings[(size_t)CheckersColor::kCount][kSquareCount];
+	ZobristKey m_lightToMove;
+};
+
+// SplitMix64, returns the next random number and advances state
+constexpr uint64_t SplitMix64(uint64_t& state)
+{
+	uint64_t value = (state += 0x9E3779B97F4A7C15ULL);
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+	return value ^ (value >> 31);
+}
+
+constexpr ZobristTable BuildZobristTable()
+{
+	ZobristTable table{};
+	uint64_t state = kZobristSeed;
+	for (size_t side = 0; side < (size_t)CheckersColor::kCount; ++side)
+	{
+		for (size_t square = 0; square < kSquareCount; ++square)
+		{
+			table.m_men[side][square] = SplitMix64(state);
+			table.m_kings[side][square] = SplitMix64(state);
+		}
+	}
+	table.m_lightToMove = SplitMix64(state);
+	return table;
+}
+
+static constexpr ZobristTable kZobrist = BuildZobristTable();
+
+//--------------------------------------------------------------------------------------------------------------
+// Hashing
+//--------------------------------------------------------------------------------------------------------------
+// Return the key of one piece, XOR it in when the piece appears and again when it leaves
+constexpr ZobristKey GetPieceKey(CheckersColor side, size_t square, bool isKing)
+{
+	return isKing ? kZobrist.m_kings[(size_t)side][square] : kZobrist.m_men[(size_t)side][square];
+}
+
+// Return the key of the side to move
+constexpr ZobristKey GetSideKey(CheckersColor side)
+{
+	return (side == CheckersColor::kLight) ? kZobrist.m_lightToMove : 0;
+}
+
+// Hash a whole position from scratch. GameState keeps its hash up to date incrementally, this is for checking it
+inline ZobristKey ComputeHash(const Position& position)
+{
+	ZobristKey hash = GetSideKey(position.m_sideToMove);
+	for (size_t side = 0; side < (size_t)CheckersColor::kCount; ++side)
+	{
+		Bitboard pieces = position.m_pieces[side];
+		while (pieces)
+		{
+			size_t square = PopLowestSquare(pieces);
+			hash ^= GetPieceKey((CheckersColor)side, square, position.IsKing(square));
+		}
+	}
+	return hash;
+}
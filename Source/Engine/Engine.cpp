@@ -0,0 +1,384 @@
+#include "Engine.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <bit>
+
+//---------------------------------------------------------------------------------------------------------------------
+// Return how many rows the men of side have walked in total
+//---------------------------------------------------------------------------------------------------------------------
+static int GetAdvancement(CheckersColor side, Bitboard men)
+{
+	int rows = 0;
+	while (men)
+	{
+		size_t row = PopLowestSquare(men) / kSquaresPerRow;
+		rows += (int)((side == CheckersColor::kDark) ? (kBoardHeight - 1 - row) : row);
+	}
+	return rows;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Return the score of side's pieces alone
+//---------------------------------------------------------------------------------------------------------------------
+static int EvaluateSide(const Position& position, CheckersColor side, const EvalWeights& weights)
+{
+	Bitboard pieces = position.m_pieces[(size_t)side];
+	Bitboard kings = pieces & position.m_kings;
+	Bitboard men = pieces & ~position.m_kings;
+	Bitboard backRow = (side == CheckersColor::kDark) ? kBottomRow : kTopRow;
+
+	return std::popcount(men) * weights.m_man
+		+ std::popcount(kings) * weights.m_king
+		+ GetAdvancement(side, men) * weights.m_advance
+		+ std::popcount(men & backRow) * weights.m_backRow;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Put the moves most likely to cut first: the longest captures, then moves that crown
+//---------------------------------------------------------------------------------------------------------------------
+static int GetMoveOrder(const Position& position, const Move& move)
+{
+	Bitboard promotionRow = (position.m_sideToMove == CheckersColor::kDark) ? kTopRow : kBottomRow;
+	bool isCrowning = !position.IsKing(move.From()) && (GetSquareMask(move.Dest()) & promotionRow);
+	return std::popcount(move.m_captured) * 2 + (isCrowning ? 1 : 0);
+}
+
+static void OrderMoves(const Position& position, MoveList& moves)
+{
+	std::stable_sort(moves.begin(), moves.end(), [&position](const Move& left, const Move& right)
+	{
+		return GetMoveOrder(position, left) > GetMoveOrder(position, right);
+	});
+}
+
+// Move the table's best move to the front, it already refuted everything else once
+static void OrderBestMoveFirst(const TableEntry& entry, MoveList& moves)
+{
+	for (size_t i = 0; i < moves.Size(); ++i)
+	{
+		if (entry.IsBestMove(moves[i]))
+		{
+			std::rotate(moves.begin(), moves.begin() + i, moves.begin() + i + 1);
+			return;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Win scores count plies from the root, the table stores them counting from the position instead so they stay true
+// when the same position is reached at another ply
+//---------------------------------------------------------------------------------------------------------------------
+static int ScoreToTable(int score, size_t ply)
+{
+	if (score >= kMinWinScore)
+		return score + (int)ply;
+	if (score <= -kMinWinScore)
+		return score - (int)ply;
+	return score;
+}
+
+static int ScoreFromTable(int score, size_t ply)
+{
+	if (score >= kMinWinScore)
+		return score - (int)ply;
+	if (score <= -kMinWinScore)
+		return score + (int)ply;
+	return score;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Helper threads skip depths in different patterns so they spread over the next few depths instead of all searching
+// the same one. Helper i uses entry (i - 1) % kSkipPatternCount
+//---------------------------------------------------------------------------------------------------------------------
+static constexpr size_t kSkipPatternCount = 20;
+static constexpr size_t kSkipSize[kSkipPatternCount] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static constexpr size_t kSkipPhase[kSkipPatternCount] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+Engine::Engine(TranspositionTable& table, size_t threadIndex)
+	: m_state{}
+	, m_table{ table }
+	, m_threadIndex{ threadIndex }
+	, m_pStopSignal{ nullptr }
+	, m_pTablebase{ nullptr }
+	, m_weights{}
+	, m_deadline{}
+	, m_hasDeadline{ false }
+	, m_isStopped{ false }
+	, m_nodes{ 0 }
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Find the best move for the side to move in position, searching one ply deeper each iteration until a limit is hit.
+// An iteration cut short by the clock is thrown away, so the result always comes from a completed depth
+//		-position: Where to search from
+//		-limits: Maximum depth and time budget
+//---------------------------------------------------------------------------------------------------------------------
+SearchResult Engine::Search(const Position& position, const SearchLimits& limits)
+{
+	Clock::time_point begin = Clock::now();
+	m_hasDeadline = (limits.m_timeBudgetMs > 0);
+	m_deadline = begin + std::chrono::milliseconds(limits.m_timeBudgetMs);
+	m_isStopped = false;
+	m_nodes = 0;
+	m_state.SetPosition(position);
+
+	SearchResult result;
+	MoveList rootMoves;
+	if (m_state.GetLegalMoves(rootMoves) == 0)
+	{
+		result.m_score = -kWinScore;
+		return result;
+	}
+
+	OrderMoves(position, rootMoves);
+	result.m_bestMove = rootMoves[0];
+	result.m_hasMove = true;
+
+	// Nothing to think about
+	if (rootMoves.Size() == 1)
+		return result;
+
+	// Few enough pieces to play perfectly from the tablebase
+	if (PickTablebaseMove(rootMoves, result))
+	{
+		result.m_seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+		return result;
+	}
+
+	for (size_t depth = 1; depth <= limits.m_maxDepth; ++depth)
+	{
+		if (IsSkippedDepth(depth))
+			continue;
+
+		int alpha = -kInfiniteScore;
+		size_t bestIndex = 0;
+
+		for (size_t i = 0; i < rootMoves.Size(); ++i)
+		{
+			m_state.MakeMove(rootMoves[i]);
+			int score = -Negamax((int)depth - 1, -kInfiniteScore, -alpha, 1);
+			m_state.UnmakeMove();
+
+			if (m_isStopped)
+				break;
+
+			if (score > alpha)
+			{
+				alpha = score;
+				bestIndex = i;
+			}
+		}
+
+		if (m_isStopped)
+			break;
+
+		result.m_bestMove = rootMoves[bestIndex];
+		result.m_score = alpha;
+		result.m_depth = depth;
+		m_table.Store(m_state.GetHash(), (int)depth, ScoreToTable(alpha, 0), Bound::kExact, &rootMoves[bestIndex]);
+
+		// Search the best move first next iteration, it's the most likely to still be best
+		std::rotate(rootMoves.begin(), rootMoves.begin() + bestIndex, rootMoves.begin() + bestIndex + 1);
+
+		// A forced win or loss won't change with more depth
+		if (std::abs(alpha) >= kMinWinScore)
+			break;
+	}
+
+	result.m_nodes = m_nodes;
+	result.m_seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Static evaluation of position from the side to move's point of view
+//---------------------------------------------------------------------------------------------------------------------
+int Engine::Evaluate(const Position& position) const
+{
+	CheckersColor side = position.m_sideToMove;
+	return EvaluateSide(position, side, m_weights) - EvaluateSide(position, GetOpponent(side), m_weights);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Alpha-beta search of m_state, returns its score from the side to move's point of view
+//		-depth: Plies left before quiescence takes over
+//		-ply: Plies from the root, to prefer quicker wins
+//---------------------------------------------------------------------------------------------------------------------
+int Engine::Negamax(int depth, int alpha, int beta, size_t ply)
+{
+	if (depth <= 0)
+		return Quiescence(alpha, beta, ply);
+
+	if (ShouldStop())
+		return 0;
+
+	int tablebaseScore = 0;
+	if (ProbeTablebase(ply, tablebaseScore))
+		return tablebaseScore;
+
+	// A deep enough result from before may settle this position without searching it
+	ZobristKey hash = m_state.GetHash();
+	TableEntry entry;
+	bool isHit = m_table.Probe(hash, entry);
+	if (isHit && entry.m_depth >= depth)
+	{
+		int score = ScoreFromTable(entry.m_score, ply);
+		if (entry.m_bound == Bound::kExact
+			|| (entry.m_bound == Bound::kLower && score >= beta)
+			|| (entry.m_bound == Bound::kUpper && score <= alpha))
+		{
+			return score;
+		}
+	}
+
+	MoveList moves;
+	if (m_state.GetLegalMoves(moves) == 0)
+		return -kWinScore + (int)ply;
+
+	OrderMoves(m_state.GetPosition(), moves);
+	if (isHit)
+		OrderBestMoveFirst(entry, moves);
+
+	int originalAlpha = alpha;
+	int bestScore = -kInfiniteScore;
+	const Move* pBestMove = nullptr;
+
+	for (const Move& move : moves)
+	{
+		m_state.MakeMove(move);
+		int score = -Negamax(depth - 1, -beta, -alpha, ply + 1);
+		m_state.UnmakeMove();
+
+		if (m_isStopped)
+			return 0;
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			if (score > alpha)
+			{
+				alpha = score;
+				pBestMove = &move;
+			}
+		}
+
+		if (score >= beta)
+			break;
+	}
+
+	Bound bound = (bestScore >= beta) ? Bound::kLower : ((bestScore > originalAlpha) ? Bound::kExact : Bound::kUpper);
+	m_table.Store(hash, depth, ScoreToTable(bestScore, ply), bound, pBestMove);
+	return bestScore;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Only evaluate quiet positions. Captures are mandatory in checkers, so when one is pending every capture is searched
+// and there's no standing pat
+//---------------------------------------------------------------------------------------------------------------------
+int Engine::Quiescence(int alpha, int beta, size_t ply)
+{
+	if (ShouldStop())
+		return 0;
+
+	MoveList moves;
+	if (m_state.GetLegalMoves(moves) == 0)
+		return -kWinScore + (int)ply;
+
+	if (!moves[0].IsCapture() || ply >= kMaxSearchPly)
+		return Evaluate(m_state.GetPosition());
+
+	OrderMoves(m_state.GetPosition(), moves);
+
+	for (const Move& move : moves)
+	{
+		m_state.MakeMove(move);
+		int score = -Quiescence(-beta, -alpha, ply + 1);
+		m_state.UnmakeMove();
+
+		if (m_isStopped)
+			return 0;
+
+		if (score >= beta)
+			return score;
+		alpha = (std::max)(alpha, score);
+	}
+	return alpha;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Count a node and check the clock every so often, returns true once the search has to give up
+//---------------------------------------------------------------------------------------------------------------------
+bool Engine::ShouldStop()
+{
+	if ((++m_nodes & kTimeCheckMask) == 0)
+	{
+		if ((m_hasDeadline && Clock::now() >= m_deadline) || (m_pStopSignal && m_pStopSignal->load(std::memory_order_relaxed)))
+			m_isStopped = true;
+	}
+	return m_isStopped;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Score m_state from the tablebase, returns false if it's not in there
+//		-ply: Plies from the root, wins are scored like the search scores them
+//---------------------------------------------------------------------------------------------------------------------
+bool Engine::ProbeTablebase(size_t ply, int& score) const
+{
+	TablebaseResult result;
+	if (!m_pTablebase || !m_pTablebase->Probe(m_state.GetPosition(), result))
+		return false;
+
+	int distance = (int)(ply + result.m_distance);
+	if (result.m_outcome == TablebaseOutcome::kWin)
+		score = kWinScore - distance;
+	else if (result.m_outcome == TablebaseOutcome::kLoss)
+		score = -kWinScore + distance;
+	else
+		score = 0;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Pick the root move with the best tablebase score: the quickest win, else a draw, else the slowest loss.
+// Returns false if the root or any of its children isn't in the tablebase
+//---------------------------------------------------------------------------------------------------------------------
+bool Engine::PickTablebaseMove(const MoveList& rootMoves, SearchResult& result)
+{
+	int score = 0;
+	if (!ProbeTablebase(0, score))
+		return false;
+
+	int bestScore = -kInfiniteScore;
+	for (const Move& move : rootMoves)
+	{
+		m_state.MakeMove(move);
+		bool isFound = ProbeTablebase(1, score);
+		m_state.UnmakeMove();
+
+		if (!isFound)
+			return false;
+
+		if (-score > bestScore)
+		{
+			bestScore = -score;
+			result.m_bestMove = move;
+		}
+	}
+
+	result.m_score = bestScore;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns true if this thread should leave depth to the others. The main thread and depth 1 are never skipped
+//---------------------------------------------------------------------------------------------------------------------
+bool Engine::IsSkippedDepth(size_t depth) const
+{
+	if (m_threadIndex == 0 || depth == 1)
+		return false;
+
+	size_t pattern = (m_threadIndex - 1) % kSkipPatternCount;
+	return ((depth + kSkipPhase[pattern]) / kSkipSize[pattern]) % 2 != 0;
+}
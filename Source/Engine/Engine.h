@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Checkers/GameState.h"
+#include "Checkers/MoveGenerator.h"
+#include "Checkers/Position.h"
+#include "Tablebase.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+//--------------------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------------------
+static constexpr int kInfiniteScore = 32000;
+static constexpr int kWinScore = 30000;					// Score of a won position, minus the plies it takes to get there
+static constexpr int kMinWinScore = kWinScore - 1024;	// Any score above is a forced win, tablebase distances included
+static constexpr size_t kMaxSearchDepth = 64;			// Deepest iteration of iterative deepening
+static constexpr size_t kMaxSearchPly = 128;			// Quiescence stops here, must stay below GameState's undo depth
+static constexpr uint32_t kBotTimeBudgetMs = 500;		// How long the bot thinks about each move
+static constexpr size_t kBotTableSizeMb = 16;			// Transposition table of the bot
+static constexpr size_t kBotThreadCount = 0;			// Search threads of the bot, 0 for one per core
+
+//--------------------------------------------------------------------------------------------------------------
+// Evaluation weights, in hundredths of a man. Tunable so two configurations can be played against each other
+//--------------------------------------------------------------------------------------------------------------
+struct EvalWeights
+{
+	int m_man = 100;
+	int m_king = 140;
+	int m_advance = 3;		// Per row a man has walked toward the promotion row
+	int m_backRow = 8;		// Per man still guarding its own back row against crowning
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// What a search may spend. It stops at whichever limit comes first
+//--------------------------------------------------------------------------------------------------------------
+struct SearchLimits
+{
+	size_t m_maxDepth = kMaxSearchDepth;
+	uint32_t m_timeBudgetMs = 0;		// 0 for no time limit
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Best move found by the deepest completed iteration
+//--------------------------------------------------------------------------------------------------------------
+struct SearchResult
+{
+	Move m_bestMove;
+	bool m_hasMove = false;			// False if the side to move has no legal move, the game is over
+	int m_score = 0;				// From the side to move's point of view
+	size_t m_depth = 0;				// Deepest completed iteration, 0 for a forced move
+	uint64_t m_nodes = 0;
+	double m_seconds = 0.0;
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Negamax alpha-beta search with iterative deepening and a quiescence search that resolves pending captures.
+// Results are kept in a transposition table, which may be shared with other engines
+//--------------------------------------------------------------------------------------------------------------
+class Engine
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Constants
+	static constexpr uint64_t kTimeCheckMask = 1023;		// Read the clock once every this many + 1 nodes
+
+	GameState m_state;
+	TranspositionTable& m_table;
+	size_t m_threadIndex;							// 0 for the main thread, helpers skip some depths
+	const std::atomic<bool>* m_pStopSignal;			// Set by someone else to stop the search early, may be nullptr
+	const Tablebase* m_pTablebase;					// Exact scores for positions with few pieces, may be nullptr
+	EvalWeights m_weights;
+	Clock::time_point m_deadline;
+	bool m_hasDeadline;
+	bool m_isStopped;
+	uint64_t m_nodes;
+
+public:
+	Engine(TranspositionTable& table, size_t threadIndex = 0);
+
+	// The caller starts each search with TranspositionTable::NewSearch, helpers share the main thread's generation
+	SearchResult Search(const Position& position, const SearchLimits& limits);
+	void SetStopSignal(const std::atomic<bool>* pStopSignal) { m_pStopSignal = pStopSignal; }
+	void SetTablebase(const Tablebase* pTablebase) { m_pTablebase = pTablebase; }
+	void SetWeights(const EvalWeights& weights) { m_weights = weights; }
+
+	// Static evaluation of position from the side to move's point of view
+	int Evaluate(const Position& position) const;
+
+private:
+	int Negamax(int depth, int alpha, int beta, size_t ply);
+	int Quiescence(int alpha, int beta, size_t ply);
+	bool ShouldStop();
+	bool IsSkippedDepth(size_t depth) const;
+	bool ProbeTablebase(size_t ply, int& score) const;
+	bool PickTablebaseMove(const MoveList& rootMoves, SearchResult& result);
+};
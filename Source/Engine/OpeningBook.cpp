@@ -0,0 +1,115 @@
+#include "OpeningBook.h"
+
+#include <algorithm>
+#include <string.h>
+
+static_assert(sizeof(OpeningBookHeader) == 16 && sizeof(OpeningBookEntry) == 16, "The file layout must not depend on padding");
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns true if this entry is move
+//---------------------------------------------------------------------------------------------------------------------
+bool OpeningBookEntry::IsMove(const Move& move) const
+{
+	return move.From() == m_from && move.Dest() == m_dest && move.m_captured == m_captured;
+}
+
+OpeningBook::OpeningBook()
+	: m_file{}
+	, m_pEntries{ nullptr }
+	, m_entryCount{ 0 }
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Map the book at path, returns false if it's missing or isn't a book of this version
+//---------------------------------------------------------------------------------------------------------------------
+bool OpeningBook::Load(const std::string& path)
+{
+	m_pEntries = nullptr;
+	m_entryCount = 0;
+	if (!m_file.Open(path))
+		return false;
+
+	const uint8_t* pData = m_file.GetData();
+	size_t size = m_file.GetSize();
+
+	const OpeningBookHeader* pHeader = reinterpret_cast<const OpeningBookHeader*>(pData);
+	if (size < sizeof(OpeningBookHeader)
+		|| memcmp(pHeader->m_magic, kOpeningBookMagic, sizeof(kOpeningBookMagic)) != 0
+		|| pHeader->m_version != kOpeningBookVersion
+		|| size != sizeof(OpeningBookHeader) + pHeader->m_entryCount * sizeof(OpeningBookEntry))
+	{
+		m_file.Close();
+		return false;
+	}
+
+	m_pEntries = reinterpret_cast<const OpeningBookEntry*>(pData + sizeof(OpeningBookHeader));
+	m_entryCount = (size_t)pHeader->m_entryCount;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Every entry of key, heaviest first
+//		-pFirst: Returns the first entry, only valid if there's at least one
+//---------------------------------------------------------------------------------------------------------------------
+size_t OpeningBook::Find(ZobristKey key, const OpeningBookEntry*& pFirst) const
+{
+	const OpeningBookEntry* pEnd = m_pEntries + m_entryCount;
+	pFirst = std::lower_bound(m_pEntries, pEnd, key, [](const OpeningBookEntry& entry, ZobristKey value) { return entry.m_key < value; });
+
+	const OpeningBookEntry* pLast = pFirst;
+	while (pLast != pEnd && pLast->m_key == key)
+		++pLast;
+	return (size_t)(pLast - pFirst);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Pick a legal book move of position at random, in proportion to the weights. Returns false if the position isn't
+// in the book, so a hash collision can only ever pick among legal moves
+//		-random: Any 64 bit number, the same number picks the same move
+//---------------------------------------------------------------------------------------------------------------------
+bool OpeningBook::PickMove(const Position& position, uint64_t random, Move& move) const
+{
+	if (!IsLoaded())
+		return false;
+
+	const OpeningBookEntry* pFirst = nullptr;
+	size_t count = Find(ComputeHash(position), pFirst);
+	if (count == 0)
+		return false;
+
+	MoveList moves;
+	GenerateMoves(position, position.m_sideToMove, moves);
+
+	// Book moves that are legal here, and their weights
+	MoveList candidates;
+	uint32_t weights[kMaxMoves];
+	uint64_t totalWeight = 0;
+	for (size_t i = 0; i < count && candidates.Size() < kMaxMoves; ++i)
+	{
+		for (const Move& legal : moves)
+		{
+			if (pFirst[i].m_weight == 0 || !pFirst[i].IsMove(legal))
+				continue;
+
+			weights[candidates.m_count] = pFirst[i].m_weight;
+			candidates[candidates.m_count++] = legal;
+			totalWeight += pFirst[i].m_weight;
+			break;
+		}
+	}
+	if (totalWeight == 0)
+		return false;
+
+	uint64_t pick = random % totalWeight;
+	for (size_t i = 0; i < candidates.Size(); ++i)
+	{
+		if (pick < weights[i])
+		{
+			move = candidates[i];
+			return true;
+		}
+		pick -= weights[i];
+	}
+	return false;
+}
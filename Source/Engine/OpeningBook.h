@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Checkers/MoveGenerator.h"
+#include "Checkers/Position.h"
+#include "Checkers/Zobrist.h"
+#include "Utils/File/MappedFile.h"
+
+#include <cstdint>
+#include <string>
+
+//--------------------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------------------
+static constexpr uint32_t kOpeningBookVersion = 1;
+static constexpr char kOpeningBookMagic[4] = { 'C', 'K', 'O', 'B' };
+inline static const std::string kOpeningBookPath = "Assets/Book/Opening.ckob";
+
+//--------------------------------------------------------------------------------------------------------------
+// File layout: a header, then every entry sorted by key, heaviest move first among entries of the same key.
+// An entry is one move out of one position, its weight is how good the games that played it went for the mover
+//--------------------------------------------------------------------------------------------------------------
+struct OpeningBookHeader
+{
+	char m_magic[4];
+	uint32_t m_version;
+	uint64_t m_entryCount;
+};
+
+struct OpeningBookEntry
+{
+	ZobristKey m_key;			// Position before the move
+	Bitboard m_captured;		// Tells apart jumps with the same ends
+	uint8_t m_from;
+	uint8_t m_dest;
+	uint16_t m_weight;
+
+	bool IsMove(const Move& move) const;
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Read-only view of an opening book file, memory mapped like Tablebase. Looking a position up is a binary
+// search over the sorted entries
+//--------------------------------------------------------------------------------------------------------------
+class OpeningBook
+{
+	MappedFile m_file;
+	const OpeningBookEntry* m_pEntries;
+	size_t m_entryCount;
+
+public:
+	OpeningBook();
+
+	bool Load(const std::string& path);
+	bool IsLoaded() const { return m_file.IsOpen(); }
+	size_t GetEntryCount() const { return m_entryCount; }
+
+	// Every entry of key, heaviest first. Returns how many there are
+	size_t Find(ZobristKey key, const OpeningBookEntry*& pFirst) const;
+
+	// Pick a legal book move of position at random, in proportion to the weights. random is any 64 bit number
+	bool PickMove(const Position& position, uint64_t random, Move& move) const;
+};
@@ -0,0 +1,113 @@
+#include "OpeningBookBuilder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+OpeningBookBuilder::OpeningBookBuilder(size_t maxPly)
+	: m_positions{}
+	, m_maxPly{ maxPly }
+	, m_gameCount{ 0 }
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Count the first m_maxPly moves of a finished game. Returns false, counting nothing, if the result is unknown
+// or the game doesn't start from the starting position
+//---------------------------------------------------------------------------------------------------------------------
+bool OpeningBookBuilder::AddGame(const GameRecord& record)
+{
+	if (record.m_result == GameResult::kUnknown || !(record.m_start == Position::StartPosition()))
+		return false;
+
+	Position position = record.m_start;
+	size_t plies = (std::min)(record.m_moves.size(), m_maxPly);
+	for (size_t ply = 0; ply < plies; ++ply)
+	{
+		const Move& move = record.m_moves[ply];
+		std::vector<MoveStats>& moves = m_positions[ComputeHash(position)];
+
+		auto it = std::find_if(moves.begin(), moves.end(), [&move](const MoveStats& stats)
+		{
+			return stats.m_from == move.From() && stats.m_dest == move.Dest() && stats.m_captured == move.m_captured;
+		});
+		if (it == moves.end())
+		{
+			MoveStats& stats = moves.emplace_back();
+			stats.m_captured = move.m_captured;
+			stats.m_from = (uint8_t)move.From();
+			stats.m_dest = (uint8_t)move.Dest();
+			it = moves.end() - 1;
+		}
+
+		it->m_points += (uint64_t)(GetGameScore(record.m_result, position.m_sideToMove) * 2.0);
+		++it->m_games;
+
+		ApplyMove(position, move);
+	}
+
+	++m_gameCount;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Entries in file order: by key, then heaviest first
+//		-minGames: Leave out moves played in fewer games, a single lucky game shouldn't make a book move
+//---------------------------------------------------------------------------------------------------------------------
+std::vector<OpeningBookEntry> OpeningBookBuilder::BuildEntries(size_t minGames) const
+{
+	std::vector<OpeningBookEntry> entries;
+	for (const auto& [key, moves] : m_positions)
+	{
+		for (const MoveStats& stats : moves)
+		{
+			if (stats.m_games < minGames || stats.m_points == 0)
+				continue;
+
+			OpeningBookEntry entry;
+			entry.m_key = key;
+			entry.m_captured = stats.m_captured;
+			entry.m_from = stats.m_from;
+			entry.m_dest = stats.m_dest;
+			entry.m_weight = (uint16_t)(std::min)(stats.m_points, (uint64_t)UINT16_MAX);
+			entries.emplace_back(entry);
+		}
+	}
+
+	// Moves tied on weight are ordered by squares, so the same games always make the same file
+	std::sort(entries.begin(), entries.end(), [](const OpeningBookEntry& left, const OpeningBookEntry& right)
+	{
+		if (left.m_key != right.m_key)
+			return left.m_key < right.m_key;
+		if (left.m_weight != right.m_weight)
+			return left.m_weight > right.m_weight;
+		if (left.m_from != right.m_from)
+			return left.m_from < right.m_from;
+		if (left.m_dest != right.m_dest)
+			return left.m_dest < right.m_dest;
+		return left.m_captured < right.m_captured;
+	});
+	return entries;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Write the book file, returns false if it can't be written
+//---------------------------------------------------------------------------------------------------------------------
+bool OpeningBookBuilder::Save(const std::string& path, size_t minGames) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::vector<OpeningBookEntry> entries = BuildEntries(minGames);
+
+	OpeningBookHeader header;
+	memcpy(header.m_magic, kOpeningBookMagic, sizeof(kOpeningBookMagic));
+	header.m_version = kOpeningBookVersion;
+	header.m_entryCount = entries.size();
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(entries.data()), (std::streamsize)(entries.size() * sizeof(OpeningBookEntry)));
+
+	file.close();
+	return !file.fail();
+}
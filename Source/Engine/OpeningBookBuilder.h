@@ -0,0 +1,45 @@
+#pragma once
+
+#include "OpeningBook.h"
+#include "Checkers/GameRecord.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------------------
+// Collects the opening moves of finished games, recorded or played by the engine, then writes the sorted file
+// OpeningBook maps. A move's weight is two points for every game its side won and one for every draw
+//--------------------------------------------------------------------------------------------------------------
+class OpeningBookBuilder
+{
+public:
+	// Constants
+	static constexpr size_t kDefaultMaxPly = 16;	// Only the first plies of a game go in the book
+
+private:
+	struct MoveStats
+	{
+		Bitboard m_captured = 0;
+		uint8_t m_from = 0;
+		uint8_t m_dest = 0;
+		uint64_t m_points = 0;		// 2 per win, 1 per draw
+		uint64_t m_games = 0;
+	};
+
+	std::unordered_map<ZobristKey, std::vector<MoveStats>> m_positions;
+	size_t m_maxPly;
+	size_t m_gameCount;
+
+public:
+	OpeningBookBuilder(size_t maxPly = kDefaultMaxPly);
+
+	bool AddGame(const GameRecord& record);
+	size_t GetGameCount() const { return m_gameCount; }
+	size_t GetPositionCount() const { return m_positions.size(); }
+
+	// Entries in file order, leaving out moves played in fewer than minGames games and moves that never scored
+	std::vector<OpeningBookEntry> BuildEntries(size_t minGames) const;
+	bool Save(const std::string& path, size_t minGames) const;
+};
@@ -0,0 +1,78 @@
+#include "SearchPool.h"
+
+#include <algorithm>
+#include <thread>
+
+SearchPool::SearchPool(TranspositionTable& table, size_t threadCount)
+	: m_table{ table }
+	, m_engines{}
+	, m_stopSignal{ false }
+	, m_pTablebase{ nullptr }
+{
+	SetThreadCount(threadCount);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Set how many threads search, must not be called while searching
+//		-threadCount: 0 for one per core
+//---------------------------------------------------------------------------------------------------------------------
+void SearchPool::SetThreadCount(size_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = (std::max)((size_t)1, (size_t)std::thread::hardware_concurrency());
+
+	m_engines.clear();
+	for (size_t i = 0; i < threadCount; ++i)
+	{
+		m_engines.emplace_back(std::make_unique<Engine>(m_table, i));
+		m_engines.back()->SetStopSignal(&m_stopSignal);
+		m_engines.back()->SetTablebase(m_pTablebase);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Let every thread use pTablebase, nullptr to stop using one. Must not be called while searching
+//---------------------------------------------------------------------------------------------------------------------
+void SearchPool::SetTablebase(const Tablebase* pTablebase)
+{
+	m_pTablebase = pTablebase;
+	for (std::unique_ptr<Engine>& pEngine : m_engines)
+		pEngine->SetTablebase(pTablebase);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Search position on every thread until the main thread hits a limit, returns the deepest completed result.
+// Nodes are summed over every thread
+//---------------------------------------------------------------------------------------------------------------------
+SearchResult SearchPool::Search(const Position& position, const SearchLimits& limits)
+{
+	m_table.NewSearch();
+	m_stopSignal.store(false, std::memory_order_relaxed);
+
+	std::vector<SearchResult> results(m_engines.size());
+	std::vector<std::thread> helpers;
+	helpers.reserve(m_engines.size() - 1);
+	for (size_t i = 1; i < m_engines.size(); ++i)
+		helpers.emplace_back([this, &position, &limits, &results, i]() { results[i] = m_engines[i]->Search(position, limits); });
+
+	results[0] = m_engines[0]->Search(position, limits);
+
+	m_stopSignal.store(true, std::memory_order_relaxed);
+	for (std::thread& helper : helpers)
+		helper.join();
+
+	SearchResult best = results[0];
+	uint64_t nodes = 0;
+	for (const SearchResult& result : results)
+	{
+		nodes += result.m_nodes;
+		if (result.m_hasMove && result.m_depth > best.m_depth)
+		{
+			best.m_bestMove = result.m_bestMove;
+			best.m_score = result.m_score;
+			best.m_depth = result.m_depth;
+		}
+	}
+	best.m_nodes = nodes;
+	return best;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Engine.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------------------
+// Lazy SMP: every thread searches the same root position with its own Engine, sharing one transposition table.
+// Threads help each other through the table alone, the main thread's answer is used unless a helper got deeper
+//--------------------------------------------------------------------------------------------------------------
+class SearchPool
+{
+	TranspositionTable& m_table;
+	std::vector<std::unique_ptr<Engine>> m_engines;		// One per thread, the first runs on the calling thread
+	std::atomic<bool> m_stopSignal;						// Raised by the main thread when it's done, helpers follow
+	const Tablebase* m_pTablebase;
+
+public:
+	SearchPool(TranspositionTable& table, size_t threadCount = 0);
+
+	void SetThreadCount(size_t threadCount);
+	size_t GetThreadCount() const { return m_engines.size(); }
+	void SetTablebase(const Tablebase* pTablebase);
+
+	SearchResult Search(const Position& position, const SearchLimits& limits);
+};
@@ -0,0 +1,40 @@
+#include "SelfPlay.h"
+
+#include "Checkers/Zobrist.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Play one game from the starting position
+//		-seed: Picks the random opening plies, the same seed opens the same way
+//---------------------------------------------------------------------------------------------------------------------
+GameRecord PlaySelfPlayGame(const SelfPlayPlayer& dark, const SelfPlayPlayer& light, const SelfPlaySettings& settings, uint64_t seed)
+{
+	GameRecord record;
+	record.m_result = GameResult::kDraw;
+
+	Position position = record.m_start;
+	while (record.m_moves.size() < settings.m_maxPlies)
+	{
+		MoveList moves;
+		if (GenerateMoves(position, position.m_sideToMove, moves) == 0)
+		{
+			record.m_result = (position.m_sideToMove == CheckersColor::kDark) ? GameResult::kLightWins : GameResult::kDarkWins;
+			break;
+		}
+
+		Move move;
+		if (record.m_moves.size() < settings.m_randomPlies)
+		{
+			move = moves[(size_t)(SplitMix64(seed) % moves.Size())];
+		}
+		else
+		{
+			const SelfPlayPlayer& player = (position.m_sideToMove == CheckersColor::kDark) ? dark : light;
+			player.m_table.NewSearch();
+			move = player.m_engine.Search(position, player.m_limits).m_bestMove;
+		}
+
+		ApplyMove(position, move);
+		record.m_moves.emplace_back(move);
+	}
+	return record;
+}
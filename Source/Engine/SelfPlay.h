@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Engine.h"
+#include "Checkers/GameRecord.h"
+
+#include <cstdint>
+
+//--------------------------------------------------------------------------------------------------------------
+// How the engine plays against itself
+//--------------------------------------------------------------------------------------------------------------
+struct SelfPlaySettings
+{
+	size_t m_randomPlies = 4;		// Opening plies picked at random, so games don't all repeat the same line
+	size_t m_maxPlies = 200;		// The game is a draw when it gets this long
+};
+
+// One side of a self-play game. Both sides may be the same engine
+struct SelfPlayPlayer
+{
+	Engine& m_engine;
+	TranspositionTable& m_table;	// The one m_engine searches with
+	SearchLimits m_limits;
+};
+
+// Play one game from the starting position. The caller owns the tables, and decides whether games share what
+// they learned. The same seed opens with the same random plies, so two players can swap sides on one opening
+GameRecord PlaySelfPlayGame(const SelfPlayPlayer& dark, const SelfPlayPlayer& light, const SelfPlaySettings& settings, uint64_t seed);
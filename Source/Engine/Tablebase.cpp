@@ -0,0 +1,253 @@
+#include "Tablebase.h"
+
+#include <array>
+#include <assert.h>
+#include <bit>
+#include <string.h>
+
+//---------------------------------------------------------------------------------------------------------------------
+// Binomial coefficients, kBinomial[n][k] = n choose k
+//---------------------------------------------------------------------------------------------------------------------
+using BinomialTable = std::array<std::array<uint64_t, kMaxTablebasePieces + 1>, kSquareCount + 1>;
+
+static constexpr BinomialTable BuildBinomialTable()
+{
+	BinomialTable table{};
+	for (size_t n = 0; n <= kSquareCount; ++n)
+	{
+		table[n][0] = 1;
+		for (size_t k = 1; k <= kMaxTablebasePieces; ++k)
+			table[n][k] = (n == 0) ? 0 : table[n - 1][k - 1] + table[n - 1][k];
+	}
+	return table;
+}
+
+static constexpr BinomialTable kBinomial = BuildBinomialTable();
+
+// Squares men may stand on, shifted down so they start at bit 0
+static constexpr size_t kDarkMenShift = kSquaresPerRow;		// Dark men never stand on the top row
+static constexpr Bitboard kMenSquares = (Bitboard(1) << kMenSquareCount) - 1;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Rank of a set of squares among every set of the same size, 0 to (n choose popcount) - 1
+//---------------------------------------------------------------------------------------------------------------------
+static uint64_t RankSquares(Bitboard squares)
+{
+	uint64_t rank = 0;
+	size_t count = 0;
+	while (squares)
+	{
+		size_t square = PopLowestSquare(squares);
+		rank += kBinomial[square][++count];
+	}
+	return rank;
+}
+
+// The set of count squares with rank
+static Bitboard UnrankSquares(uint64_t rank, size_t count, size_t squareCount)
+{
+	Bitboard squares = 0;
+	size_t square = squareCount;
+	for (size_t k = count; k > 0; --k)
+	{
+		do
+		{
+			--square;
+		} while (kBinomial[square][k] > rank);
+
+		rank -= kBinomial[square][k];
+		squares |= GetSquareMask(square);
+	}
+	return squares;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Count every kind of piece of position
+//---------------------------------------------------------------------------------------------------------------------
+Material GetMaterial(const Position& position)
+{
+	Bitboard dark = position.m_pieces[(size_t)CheckersColor::kDark];
+	Bitboard light = position.m_pieces[(size_t)CheckersColor::kLight];
+
+	Material material;
+	material.m_darkMen = (uint8_t)std::popcount(dark & ~position.m_kings);
+	material.m_darkKings = (uint8_t)std::popcount(dark & position.m_kings);
+	material.m_lightMen = (uint8_t)std::popcount(light & ~position.m_kings);
+	material.m_lightKings = (uint8_t)std::popcount(light & position.m_kings);
+	return material;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Unique small number of a material, for looking slices up in arrays
+//---------------------------------------------------------------------------------------------------------------------
+size_t GetSliceKey(const Material& material)
+{
+	static constexpr size_t kBase = kMaxTablebasePieces + 1;
+	return ((material.m_darkMen * kBase + material.m_darkKings) * kBase + material.m_lightMen) * kBase + material.m_lightKings;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// How many indices a material's slice has, both sides to move
+//---------------------------------------------------------------------------------------------------------------------
+uint64_t GetSliceSize(const Material& material)
+{
+	return kBinomial[kMenSquareCount][material.m_darkMen]
+		* kBinomial[kSquareCount][material.m_darkKings]
+		* kBinomial[kMenSquareCount][material.m_lightMen]
+		* kBinomial[kSquareCount][material.m_lightKings]
+		* (uint64_t)CheckersColor::kCount;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Index of position within the slice of material, which must be position's material.
+// Returns false if a man stands on its promotion row, such positions can't be reached
+//---------------------------------------------------------------------------------------------------------------------
+bool GetTablebaseIndex(const Position& position, const Material& material, uint64_t& index)
+{
+	Bitboard dark = position.m_pieces[(size_t)CheckersColor::kDark];
+	Bitboard light = position.m_pieces[(size_t)CheckersColor::kLight];
+	Bitboard darkMen = dark & ~position.m_kings;
+	Bitboard lightMen = light & ~position.m_kings;
+	if ((darkMen & kTopRow) || (lightMen & kBottomRow))
+		return false;
+
+	index = RankSquares(darkMen >> kDarkMenShift);
+	index = index * kBinomial[kSquareCount][material.m_darkKings] + RankSquares(dark & position.m_kings);
+	index = index * kBinomial[kMenSquareCount][material.m_lightMen] + RankSquares(lightMen);
+	index = index * kBinomial[kSquareCount][material.m_lightKings] + RankSquares(light & position.m_kings);
+	index = index * (uint64_t)CheckersColor::kCount + (uint64_t)position.m_sideToMove;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Inverse of GetTablebaseIndex. Returns false if the index puts two pieces on one square
+//---------------------------------------------------------------------------------------------------------------------
+bool GetTablebasePosition(const Material& material, uint64_t index, Position& position)
+{
+	CheckersColor sideToMove = (CheckersColor)(index % (uint64_t)CheckersColor::kCount);
+	index /= (uint64_t)CheckersColor::kCount;
+
+	uint64_t lightKingsCount = kBinomial[kSquareCount][material.m_lightKings];
+	Bitboard lightKings = UnrankSquares(index % lightKingsCount, material.m_lightKings, kSquareCount);
+	index /= lightKingsCount;
+
+	uint64_t lightMenCount = kBinomial[kMenSquareCount][material.m_lightMen];
+	Bitboard lightMen = UnrankSquares(index % lightMenCount, material.m_lightMen, kMenSquareCount);
+	index /= lightMenCount;
+
+	uint64_t darkKingsCount = kBinomial[kSquareCount][material.m_darkKings];
+	Bitboard darkKings = UnrankSquares(index % darkKingsCount, material.m_darkKings, kSquareCount);
+	index /= darkKingsCount;
+
+	Bitboard darkMen = UnrankSquares(index, material.m_darkMen, kMenSquareCount) << kDarkMenShift;
+
+	// Every kind must have squares of its own
+	if ((darkMen & darkKings) || ((darkMen | darkKings) & (lightMen | lightKings)) || (lightMen & lightKings))
+		return false;
+
+	position.m_pieces[(size_t)CheckersColor::kDark] = darkMen | darkKings;
+	position.m_pieces[(size_t)CheckersColor::kLight] = lightMen | lightKings;
+	position.m_kings = darkKings | lightKings;
+	position.m_sideToMove = sideToMove;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Convert between stored bytes and results
+//---------------------------------------------------------------------------------------------------------------------
+TablebaseResult DecodeTablebaseValue(uint8_t value)
+{
+	TablebaseResult result;
+	if (value == 0)
+		return result;
+
+	result.m_distance = (size_t)value - 1;
+	result.m_outcome = (result.m_distance % 2 == 1) ? TablebaseOutcome::kWin : TablebaseOutcome::kLoss;
+	return result;
+}
+
+uint8_t EncodeTablebaseValue(const TablebaseResult& result)
+{
+	if (result.m_outcome == TablebaseOutcome::kDraw)
+		return 0;
+
+	assert(result.m_distance <= kMaxTablebaseDistance);
+	assert((result.m_distance % 2 == 1) == (result.m_outcome == TablebaseOutcome::kWin));
+	return (uint8_t)(result.m_distance + 1);
+}
+
+Tablebase::Tablebase()
+	: m_file{}
+	, m_maxPieces{ 0 }
+	, m_slices(kSliceKeyCount, nullptr)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Map the tablebase at path, returns false if it's missing or isn't a tablebase of this version
+//---------------------------------------------------------------------------------------------------------------------
+bool Tablebase::Load(const std::string& path)
+{
+	m_maxPieces = 0;
+	std::fill(m_slices.begin(), m_slices.end(), nullptr);
+	if (!m_file.Open(path))
+		return false;
+
+	const uint8_t* pData = m_file.GetData();
+	size_t size = m_file.GetSize();
+
+	const TablebaseHeader* pHeader = reinterpret_cast<const TablebaseHeader*>(pData);
+	if (size < sizeof(TablebaseHeader)
+		|| memcmp(pHeader->m_magic, kTablebaseMagic, sizeof(kTablebaseMagic)) != 0
+		|| pHeader->m_version != kTablebaseVersion
+		|| pHeader->m_maxPieces > kMaxTablebasePieces
+		|| size < sizeof(TablebaseHeader) + (uint64_t)pHeader->m_sliceCount * sizeof(TablebaseSliceInfo))
+	{
+		m_file.Close();
+		return false;
+	}
+
+	const TablebaseSliceInfo* pSlices = reinterpret_cast<const TablebaseSliceInfo*>(pData + sizeof(TablebaseHeader));
+	for (size_t i = 0; i < pHeader->m_sliceCount; ++i)
+	{
+		const TablebaseSliceInfo& slice = pSlices[i];
+		if (slice.m_material.GetPieceCount() > pHeader->m_maxPieces
+			|| slice.m_size != GetSliceSize(slice.m_material)
+			|| slice.m_offset + slice.m_size > size)
+		{
+			m_file.Close();
+			std::fill(m_slices.begin(), m_slices.end(), nullptr);
+			return false;
+		}
+		m_slices[GetSliceKey(slice.m_material)] = &slice;
+	}
+
+	m_maxPieces = pHeader->m_maxPieces;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Look position up, returns false if it has too many pieces or its slice isn't in the file
+//---------------------------------------------------------------------------------------------------------------------
+bool Tablebase::Probe(const Position& position, TablebaseResult& result) const
+{
+	// The side to move lost its last piece
+	if (position.CountPieces(position.m_sideToMove) == 0)
+	{
+		result.m_outcome = TablebaseOutcome::kLoss;
+		result.m_distance = 0;
+		return true;
+	}
+
+	Material material = GetMaterial(position);
+	if (!IsLoaded() || material.GetPieceCount() > m_maxPieces || !material.HasBothSides())
+		return false;
+
+	const TablebaseSliceInfo* pSlice = m_slices[GetSliceKey(material)];
+	uint64_t index = 0;
+	if (!pSlice || !GetTablebaseIndex(position, material, index))
+		return false;
+
+	result = DecodeTablebaseValue(m_file.GetData()[pSlice->m_offset + index]);
+	return true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Checkers/Position.h"
+#include "Utils/File/MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------------------
+static constexpr size_t kMaxTablebasePieces = 8;						// Both sides together
+static constexpr size_t kMaxTablebaseDistance = 0xFE;					// Longest distance a value byte can hold
+static constexpr size_t kMenSquareCount = kSquareCount - kSquaresPerRow;	// A man never stands on its promotion row
+static constexpr uint32_t kTablebaseVersion = 1;
+static constexpr char kTablebaseMagic[4] = { 'C', 'K', 'T', 'B' };
+inline static const std::string kTablebasePath = "Assets/Tablebase/Endgame.cktb";
+
+//--------------------------------------------------------------------------------------------------------------
+// How many pieces of each kind are on the board. Every material has its own slice of the tablebase
+//--------------------------------------------------------------------------------------------------------------
+struct Material
+{
+	uint8_t m_darkMen = 0;
+	uint8_t m_darkKings = 0;
+	uint8_t m_lightMen = 0;
+	uint8_t m_lightKings = 0;
+
+	size_t GetPieceCount() const { return (size_t)m_darkMen + m_darkKings + m_lightMen + m_lightKings; }
+	size_t GetMenCount() const { return (size_t)m_darkMen + m_lightMen; }
+	bool HasBothSides() const { return (m_darkMen + m_darkKings) > 0 && (m_lightMen + m_lightKings) > 0; }
+	bool operator==(const Material& other) const = default;
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// File layout: a header, one slice info per material, then every slice's values, one byte per position.
+// A value of 0 is a draw, any other value is the distance to the end of the game in plies, plus one.
+// The side to move wins when the distance is odd and loses when it's even
+//--------------------------------------------------------------------------------------------------------------
+struct TablebaseHeader
+{
+	char m_magic[4];
+	uint32_t m_version;
+	uint32_t m_maxPieces;
+	uint32_t m_sliceCount;
+};
+
+struct TablebaseSliceInfo
+{
+	Material m_material;
+	uint32_t m_reserved;
+	uint64_t m_offset;		// From the start of the file
+	uint64_t m_size;		// How many positions, both sides to move
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Result of a probe, from the side to move's point of view
+//--------------------------------------------------------------------------------------------------------------
+enum class TablebaseOutcome : uint8_t
+{
+	kDraw,
+	kWin,
+	kLoss
+};
+
+struct TablebaseResult
+{
+	TablebaseOutcome m_outcome = TablebaseOutcome::kDraw;
+	size_t m_distance = 0;		// Plies until the game ends with perfect play, 0 for a draw
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Position encoding. Each kind of piece is ranked among the squares it may stand on with the combinatorial
+// number system, and the four ranks and the side to move are mixed into one index. Positions where two kinds
+// share a square have an index too, they're simply never reached
+//--------------------------------------------------------------------------------------------------------------
+static constexpr size_t kSliceKeyCount = (kMaxTablebasePieces + 1) * (kMaxTablebasePieces + 1) * (kMaxTablebasePieces + 1) * (kMaxTablebasePieces + 1);
+
+Material GetMaterial(const Position& position);
+size_t GetSliceKey(const Material& material);
+uint64_t GetSliceSize(const Material& material);
+bool GetTablebaseIndex(const Position& position, const Material& material, uint64_t& index);
+bool GetTablebasePosition(const Material& material, uint64_t index, Position& position);
+TablebaseResult DecodeTablebaseValue(uint8_t value);
+uint8_t EncodeTablebaseValue(const TablebaseResult& result);
+
+//--------------------------------------------------------------------------------------------------------------
+// Read-only view of a tablebase file, memory mapped so every process on the machine shares one copy.
+// Probing is a direct index, no search
+//--------------------------------------------------------------------------------------------------------------
+class Tablebase
+{
+	MappedFile m_file;
+	size_t m_maxPieces;
+	std::vector<const TablebaseSliceInfo*> m_slices;		// Indexed by GetSliceKey, nullptr if missing
+
+public:
+	Tablebase();
+
+	bool Load(const std::string& path);
+	bool IsLoaded() const { return m_file.IsOpen(); }
+	size_t GetMaxPieces() const { return m_maxPieces; }
+
+	bool Probe(const Position& position, TablebaseResult& result) const;
+};
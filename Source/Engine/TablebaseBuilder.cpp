@@ -0,0 +1,303 @@
+#include "TablebaseBuilder.h"
+
+#include "Checkers/MoveGenerator.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <fstream>
+#include <string.h>
+
+TablebaseBuilder::TablebaseBuilder()
+	: m_slices{}
+	, m_sliceIndices(kSliceKeyCount, -1)
+	, m_maxPieces{ 0 }
+	, m_longestDistance{ 0 }
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Solve every material with both sides on the board and at most maxPieces pieces. Returns false if a slice has
+// positions that might end further than kMaxTablebaseDistance plies away, everything after it is left unbuilt
+//		-onProgress: Called after each slice, may be empty
+//---------------------------------------------------------------------------------------------------------------------
+bool TablebaseBuilder::Build(size_t maxPieces, const ProgressCallback& onProgress)
+{
+	assert(maxPieces <= kMaxTablebasePieces);
+	m_maxPieces = maxPieces;
+	m_longestDistance = 0;
+	m_slices.clear();
+	std::fill(m_sliceIndices.begin(), m_sliceIndices.end(), -1);
+
+	// Every material, in an order where captures and crownings lead to a solved slice
+	std::vector<Material> materials;
+	for (size_t total = 2; total <= maxPieces; ++total)
+	{
+		for (size_t darkMen = 0; darkMen <= total; ++darkMen)
+		{
+			for (size_t darkKings = 0; darkMen + darkKings <= total; ++darkKings)
+			{
+				for (size_t lightMen = 0; darkMen + darkKings + lightMen <= total; ++lightMen)
+				{
+					Material material;
+					material.m_darkMen = (uint8_t)darkMen;
+					material.m_darkKings = (uint8_t)darkKings;
+					material.m_lightMen = (uint8_t)lightMen;
+					material.m_lightKings = (uint8_t)(total - darkMen - darkKings - lightMen);
+					if (material.HasBothSides())
+						materials.emplace_back(material);
+				}
+			}
+		}
+	}
+	std::stable_sort(materials.begin(), materials.end(), [](const Material& left, const Material& right)
+	{
+		if (left.GetPieceCount() != right.GetPieceCount())
+			return left.GetPieceCount() < right.GetPieceCount();
+		return left.GetMenCount() < right.GetMenCount();
+	});
+
+	m_slices.reserve(materials.size());
+	for (const Material& material : materials)
+	{
+		Slice& slice = m_slices.emplace_back();
+		slice.m_material = material;
+
+		size_t passes = 0;
+		if (!SolveSlice(slice, passes))
+		{
+			m_slices.pop_back();
+			return false;
+		}
+		m_sliceIndices[GetSliceKey(material)] = (int)(m_slices.size() - 1);
+
+		for (uint8_t value : slice.m_values)
+			m_longestDistance = (std::max)(m_longestDistance, DecodeTablebaseValue(value).m_distance);
+
+		if (onProgress)
+			onProgress(material, slice.m_values.size(), passes);
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Write the tablebase file, returns false if it can't be written
+//---------------------------------------------------------------------------------------------------------------------
+bool TablebaseBuilder::Save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	TablebaseHeader header;
+	memcpy(header.m_magic, kTablebaseMagic, sizeof(kTablebaseMagic));
+	header.m_version = kTablebaseVersion;
+	header.m_maxPieces = (uint32_t)m_maxPieces;
+	header.m_sliceCount = (uint32_t)m_slices.size();
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	uint64_t offset = sizeof(TablebaseHeader) + m_slices.size() * sizeof(TablebaseSliceInfo);
+	for (const Slice& slice : m_slices)
+	{
+		TablebaseSliceInfo info;
+		info.m_material = slice.m_material;
+		info.m_reserved = 0;
+		info.m_offset = offset;
+		info.m_size = slice.m_values.size();
+		file.write(reinterpret_cast<const char*>(&info), sizeof(info));
+		offset += info.m_size;
+	}
+
+	for (const Slice& slice : m_slices)
+		file.write(reinterpret_cast<const char*>(slice.m_values.data()), (std::streamsize)slice.m_values.size());
+
+	file.close();
+	return !file.fail();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Check every solved position against its children one ply down, returns false at the first one that disagrees
+//---------------------------------------------------------------------------------------------------------------------
+bool TablebaseBuilder::Verify() const
+{
+	for (const Slice& slice : m_slices)
+	{
+		for (uint64_t index = 0; index < slice.m_values.size(); ++index)
+		{
+			Position position;
+			if (!GetTablebasePosition(slice.m_material, index, position))
+				continue;
+
+			MoveList moves;
+			GenerateMoves(position, position.m_sideToMove, moves);
+
+			// The best child for the side to move: the quickest loss for the opponent, then a draw, then the slowest win
+			bool hasLoss = false;
+			bool hasDraw = false;
+			size_t lossDistance = kInvalidIndex;
+			size_t winDistance = 0;
+			for (const Move& move : moves)
+			{
+				Position child = position;
+				ApplyMove(child, move);
+
+				uint8_t value = 0;
+				if (!GetChildValue(slice, child, value))
+					return false;
+
+				TablebaseResult result = DecodeTablebaseValue(value);
+				if (result.m_outcome == TablebaseOutcome::kLoss)
+				{
+					hasLoss = true;
+					lossDistance = (std::min)(lossDistance, result.m_distance);
+				}
+				else if (result.m_outcome == TablebaseOutcome::kDraw)
+				{
+					hasDraw = true;
+				}
+				else
+				{
+					winDistance = (std::max)(winDistance, result.m_distance);
+				}
+			}
+
+			TablebaseResult expected;
+			if (hasLoss)
+			{
+				expected.m_outcome = TablebaseOutcome::kWin;
+				expected.m_distance = lossDistance + 1;
+			}
+			else if (!hasDraw)
+			{
+				expected.m_outcome = TablebaseOutcome::kLoss;
+				expected.m_distance = moves.Empty() ? 0 : winDistance + 1;
+			}
+
+			if (EncodeTablebaseValue(expected) != slice.m_values[index])
+				return false;
+		}
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Retrograde analysis of one slice. Pass n only settles positions that end exactly n plies from now: a loss when
+// every move leads to a win settled before, a win when a move leads to a loss n - 1 plies from the end.
+// Settling happens between passes, so a pass only ever sees what earlier passes settled. Returns false if
+// positions are still pending after the pass at kMaxTablebaseDistance, they may be longer wins than a byte holds
+//		-passes: Returns how many passes it took
+//---------------------------------------------------------------------------------------------------------------------
+bool TablebaseBuilder::SolveSlice(Slice& slice, size_t& passes)
+{
+	uint64_t size = GetSliceSize(slice.m_material);
+	slice.m_values.assign(size, 0);
+
+	// Positions not settled yet, the ones left at the end are draws
+	std::vector<uint64_t> pending;
+	for (uint64_t index = 0; index < size; ++index)
+	{
+		Position position;
+		if (GetTablebasePosition(slice.m_material, index, position))
+			pending.emplace_back(index);
+	}
+
+	std::vector<std::pair<uint64_t, uint8_t>> settled;
+	for (size_t distance = 0; ; ++distance)
+	{
+		settled.clear();
+		bool isWinPass = (distance % 2 == 1);
+
+		for (uint64_t index : pending)
+		{
+			Position position;
+			GetTablebasePosition(slice.m_material, index, position);
+
+			MoveList moves;
+			GenerateMoves(position, position.m_sideToMove, moves);
+
+			bool isSettled = isWinPass ? false : true;
+			for (const Move& move : moves)
+			{
+				Position child = position;
+				ApplyMove(child, move);
+
+				uint8_t value = 0;
+				GetChildValue(slice, child, value);
+				TablebaseResult result = DecodeTablebaseValue(value);
+
+				// Only what's known to end before this pass counts
+				bool isKnown = (value != 0) && (result.m_distance < distance);
+				if (isWinPass && isKnown && result.m_outcome == TablebaseOutcome::kLoss)
+				{
+					isSettled = true;
+					break;
+				}
+				if (!isWinPass && !(isKnown && result.m_outcome == TablebaseOutcome::kWin))
+				{
+					isSettled = false;
+					break;
+				}
+			}
+
+			if (isSettled)
+			{
+				TablebaseResult result;
+				result.m_outcome = isWinPass ? TablebaseOutcome::kWin : TablebaseOutcome::kLoss;
+				result.m_distance = distance;
+				settled.emplace_back(index, EncodeTablebaseValue(result));
+			}
+		}
+
+		for (const auto& [index, value] : settled)
+			slice.m_values[index] = value;
+
+		if (!settled.empty())
+		{
+			pending.erase(std::remove_if(pending.begin(), pending.end(), [&slice](uint64_t index) { return slice.m_values[index] != 0; }), pending.end());
+		}
+		// Nothing settles after a pass that changed nothing, once no other slice's distance can still be reached
+		else if (distance > m_longestDistance)
+		{
+			passes = distance + 1;
+			return true;
+		}
+
+		if (distance == kMaxTablebaseDistance)
+		{
+			passes = distance + 1;
+			return pending.empty();
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Value of a position one move away from a position of current, which may still be being solved.
+// Returns false if its slice isn't built, which can't happen when slices are built in order
+//---------------------------------------------------------------------------------------------------------------------
+bool TablebaseBuilder::GetChildValue(const Slice& current, const Position& child, uint8_t& value) const
+{
+	// The side to move lost its last piece
+	if (child.CountPieces(child.m_sideToMove) == 0)
+	{
+		TablebaseResult result;
+		result.m_outcome = TablebaseOutcome::kLoss;
+		value = EncodeTablebaseValue(result);
+		return true;
+	}
+
+	Material material = GetMaterial(child);
+	const Slice* pSlice = &current;
+	if (!(material == current.m_material))
+	{
+		int sliceIndex = m_sliceIndices[GetSliceKey(material)];
+		if (sliceIndex < 0)
+			return false;
+		pSlice = &m_slices[sliceIndex];
+	}
+
+	uint64_t index = 0;
+	if (!GetTablebaseIndex(child, material, index))
+		return false;
+
+	value = pSlice->m_values[index];
+	return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Tablebase.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------------------
+// Builds every slice up to a number of pieces by retrograde analysis, then writes the file Tablebase maps.
+// Slices are solved from fewest pieces up, and fewest men first among equal piece counts, so a capture or a
+// crowning always leads into a slice that's already solved. Within a slice, pass n settles every position
+// that ends n plies from now, until a pass past the longest distance out of the slice changes nothing.
+// Building fails when a slice still has unsettled positions at kMaxTablebaseDistance, rather than storing them
+// as draws
+//--------------------------------------------------------------------------------------------------------------
+class TablebaseBuilder
+{
+public:
+	// Called after each slice is solved
+	using ProgressCallback = std::function<void(const Material& material, uint64_t positions, size_t passes)>;
+
+private:
+	struct Slice
+	{
+		Material m_material;
+		std::vector<uint8_t> m_values;		// Encoded like the file
+	};
+
+	std::vector<Slice> m_slices;
+	std::vector<int> m_sliceIndices;		// Indexed by GetSliceKey, -1 if not built
+	size_t m_maxPieces;
+	size_t m_longestDistance;				// Over every slice built so far
+
+public:
+	TablebaseBuilder();
+
+	bool Build(size_t maxPieces, const ProgressCallback& onProgress);
+	bool Save(const std::string& path) const;
+	bool Verify() const;
+
+private:
+	bool SolveSlice(Slice& slice, size_t& passes);
+	bool GetChildValue(const Slice& current, const Position& child, uint8_t& value) const;
+};
@@ -0,0 +1,151 @@
+#include "TranspositionTable.h"
+
+#include <assert.h>
+#include <bit>
+
+//---------------------------------------------------------------------------------------------------------------------
+// Packed data layout, low bits first
+//---------------------------------------------------------------------------------------------------------------------
+static constexpr uint64_t kScoreShift = 0;			// 16 bits, signed
+static constexpr uint64_t kDepthShift = 16;			// 8 bits
+static constexpr uint64_t kBoundShift = 24;			// 2 bits
+static constexpr uint64_t kGenerationShift = 26;	// 6 bits
+static constexpr uint64_t kFromShift = 32;			// 5 bits, kSquareCount for no move
+static constexpr uint64_t kDestShift = 38;			// 5 bits
+static constexpr uint64_t kCapturesShift = 44;		// 16 bits
+static constexpr uint64_t kHasMoveShift = 60;		// 1 bit
+static constexpr uint64_t kGenerationMask = 0x3F;
+
+static uint16_t FoldCaptures(Bitboard captured)
+{
+	return (uint16_t)(captured ^ (captured >> 16));
+}
+
+static uint64_t GetField(uint64_t data, uint64_t shift, uint64_t mask)
+{
+	return (data >> shift) & mask;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns true if move is the stored best move
+//---------------------------------------------------------------------------------------------------------------------
+bool TableEntry::IsBestMove(const Move& move) const
+{
+	return m_hasMove
+		&& move.From() == m_moveFrom
+		&& move.Dest() == m_moveDest
+		&& FoldCaptures(move.m_captured) == m_moveCaptures;
+}
+
+TranspositionTable::TranspositionTable(size_t sizeMb)
+	: m_pSlots{}
+	, m_slotCount{ 0 }
+	, m_indexMask{ 0 }
+	, m_generation{ 0 }
+{
+	Resize(sizeMb);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Reallocate the table to the largest power of two slot count that fits in sizeMb, which also clears it.
+// Must not be called while anyone is searching
+//		-sizeMb: Memory budget in megabytes, at least one slot is always allocated
+//---------------------------------------------------------------------------------------------------------------------
+void TranspositionTable::Resize(size_t sizeMb)
+{
+	size_t slotCount = std::bit_floor((sizeMb * 1024 * 1024) / sizeof(Slot));
+	if (slotCount == 0)
+		slotCount = 1;
+
+	m_pSlots = std::make_unique<Slot[]>(slotCount);
+	m_slotCount = slotCount;
+	m_indexMask = slotCount - 1;
+	Clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Forget everything, must not be called while anyone is searching
+//---------------------------------------------------------------------------------------------------------------------
+void TranspositionTable::Clear()
+{
+	for (size_t i = 0; i < m_slotCount; ++i)
+	{
+		m_pSlots[i].m_check.store(0, std::memory_order_relaxed);
+		m_pSlots[i].m_data.store(0, std::memory_order_relaxed);
+	}
+	m_generation.store(0, std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Called once before every search, entries from older searches become the first to go
+//---------------------------------------------------------------------------------------------------------------------
+void TranspositionTable::NewSearch()
+{
+	m_generation.store((uint8_t)((m_generation.load(std::memory_order_relaxed) + 1) & kGenerationMask), std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Look up key, returns false if the table has nothing trustworthy about it
+//---------------------------------------------------------------------------------------------------------------------
+bool TranspositionTable::Probe(ZobristKey key, TableEntry& entry) const
+{
+	const Slot& slot = m_pSlots[key & m_indexMask];
+	uint64_t data = slot.m_data.load(std::memory_order_relaxed);
+	uint64_t check = slot.m_check.load(std::memory_order_relaxed);
+	if ((check ^ data) != key)
+		return false;
+
+	Bound bound = (Bound)GetField(data, kBoundShift, 0x3);
+	if (bound == Bound::kNone)
+		return false;
+
+	entry.m_score = (int16_t)GetField(data, kScoreShift, 0xFFFF);
+	entry.m_depth = (int)GetField(data, kDepthShift, 0xFF);
+	entry.m_bound = bound;
+	entry.m_moveFrom = (uint8_t)GetField(data, kFromShift, 0x1F);
+	entry.m_moveDest = (uint8_t)GetField(data, kDestShift, 0x1F);
+	entry.m_moveCaptures = (uint16_t)GetField(data, kCapturesShift, 0xFFFF);
+	entry.m_hasMove = GetField(data, kHasMoveShift, 0x1) != 0;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Save a search result. Within one search a shallower result doesn't replace a deeper one about the same position,
+// anything else is overwritten
+//		-depth: Plies searched below this position
+//		-score: Must fit in 16 bits
+//		-pBestMove: nullptr if there's no best move, e.g. after failing low
+//---------------------------------------------------------------------------------------------------------------------
+void TranspositionTable::Store(ZobristKey key, int depth, int score, Bound bound, const Move* pBestMove)
+{
+	assert(score >= INT16_MIN && score <= INT16_MAX);
+	assert(depth >= 0 && depth <= 0xFF);
+
+	Slot& slot = m_pSlots[key & m_indexMask];
+	uint64_t generation = m_generation.load(std::memory_order_relaxed);
+
+	uint64_t oldData = slot.m_data.load(std::memory_order_relaxed);
+	uint64_t oldCheck = slot.m_check.load(std::memory_order_relaxed);
+	if ((oldCheck ^ oldData) == key
+		&& GetField(oldData, kGenerationShift, kGenerationMask) == generation
+		&& (int)GetField(oldData, kDepthShift, 0xFF) > depth)
+	{
+		return;
+	}
+
+	uint64_t data = ((uint64_t)(uint16_t)(int16_t)score << kScoreShift)
+		| ((uint64_t)depth << kDepthShift)
+		| ((uint64_t)bound << kBoundShift)
+		| (generation << kGenerationShift);
+
+	if (pBestMove)
+	{
+		data |= ((uint64_t)pBestMove->From() << kFromShift)
+			| ((uint64_t)pBestMove->Dest() << kDestShift)
+			| ((uint64_t)FoldCaptures(pBestMove->m_captured) << kCapturesShift)
+			| (uint64_t(1) << kHasMoveShift);
+	}
+
+	slot.m_data.store(data, std::memory_order_relaxed);
+	slot.m_check.store(key ^ data, std::memory_order_relaxed);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Checkers/MoveGenerator.h"
+#include "Checkers/Zobrist.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+//--------------------------------------------------------------------------------------------------------------
+// What a stored score says about the real one
+//--------------------------------------------------------------------------------------------------------------
+enum class Bound : uint8_t
+{
+	kNone = 0,
+	kUpper = 1,		// Failed low, the real score is at most this
+	kLower = 2,		// Failed high, the real score is at least this
+	kExact = 3
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Unpacked contents of one table entry
+//--------------------------------------------------------------------------------------------------------------
+struct TableEntry
+{
+	int m_score = 0;
+	int m_depth = 0;
+	Bound m_bound = Bound::kNone;
+	uint8_t m_moveFrom = 0;				// Best move, matched against generated moves with IsBestMove
+	uint8_t m_moveDest = 0;
+	uint16_t m_moveCaptures = 0;		// Folded captured squares, tells apart jumps with the same ends
+	bool m_hasMove = false;
+
+	bool IsBestMove(const Move& move) const;
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Fixed size, power of two hash table of search results, shared by every search thread without locks.
+// Each slot is two 64 bit words, the packed data and the key XOR the data. A slot torn by two threads writing at
+// once fails the XOR check and reads as a miss, so no reader ever trusts half of one entry and half of another
+//--------------------------------------------------------------------------------------------------------------
+class TranspositionTable
+{
+public:
+	// Constants
+	static constexpr size_t kDefaultSizeMb = 64;
+
+private:
+	struct Slot
+	{
+		std::atomic<uint64_t> m_check;		// Key ^ m_data
+		std::atomic<uint64_t> m_data;
+	};
+
+	std::unique_ptr<Slot[]> m_pSlots;
+	size_t m_slotCount;
+	uint64_t m_indexMask;
+	std::atomic<uint8_t> m_generation;		// Bumped every search, so stale entries get replaced first
+
+public:
+	TranspositionTable(size_t sizeMb = kDefaultSizeMb);
+
+	void Resize(size_t sizeMb);
+	void Clear();
+	void NewSearch();
+
+	bool Probe(ZobristKey key, TableEntry& entry) const;
+	void Store(ZobristKey key, int depth, int score, Bound bound, const Move* pBestMove);
+
+	size_t GetSlotCount() const { return m_slotCount; }
+	size_t GetSizeBytes() const { return m_slotCount * sizeof(Slot); }
+};
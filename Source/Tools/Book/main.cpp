@@ -0,0 +1,188 @@
+#include "Checkers/GameRecord.h"
+#include "Engine/OpeningBook.h"
+#include "Engine/OpeningBookBuilder.h"
+#include "Engine/SelfPlay.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Opening book builder.
+// book [--selfplay N] [--movetime MS] [--games-out PATH] [--plies N] [--min-games N] [--out PATH] [--verify] [ARCHIVE]...
+//  -selfplay: Also let the engine play N games against itself, after random opening plies
+//  -movetime: How long the engine thinks about each self-play move, 20 milliseconds by default
+//  -games-out: Write the self-play games there as PDN, so they can be built into a book again later
+//  -plies: How many plies of every game go in the book, OpeningBookBuilder::kDefaultMaxPly by default
+//  -min-games: Leave out moves played in fewer games, 1 by default
+//  -out: Where to write the book, kOpeningBookPath by default
+//  -verify: Load the written book back and check every entry can be found
+//  -ARCHIVE: PDN files of recorded games, each game ended by its result
+
+int main(int argc, char* argv[])
+{
+    size_t selfPlayGames = 0;
+    uint32_t moveTimeMs = 20;
+    std::string gamesOutPath;
+    size_t maxPly = OpeningBookBuilder::kDefaultMaxPly;
+    size_t minGames = 1;
+    std::string path = kOpeningBookPath;
+    bool verify = false;
+    std::vector<std::string> archives;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--selfplay") == 0 && i + 1 < argc)
+        {
+            selfPlayGames = (size_t)strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--movetime") == 0 && i + 1 < argc)
+        {
+            moveTimeMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--games-out") == 0 && i + 1 < argc)
+        {
+            gamesOutPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--plies") == 0 && i + 1 < argc)
+        {
+            maxPly = (size_t)strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--min-games") == 0 && i + 1 < argc)
+        {
+            minGames = (size_t)strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--verify") == 0)
+        {
+            verify = true;
+        }
+        else if (argv[i][0] != '-')
+        {
+            archives.emplace_back(argv[i]);
+        }
+        else
+        {
+            printf("Usage: book [--selfplay N] [--movetime MS] [--games-out PATH] [--plies N] [--min-games N] [--out PATH] [--verify] [ARCHIVE]...\n");
+            return 1;
+        }
+    }
+
+    if (archives.empty() && selfPlayGames == 0)
+    {
+        printf("Nothing to build from, give archives or --selfplay\n");
+        return 1;
+    }
+
+    OpeningBookBuilder builder(maxPly);
+
+    // Recorded games
+    for (const std::string& archive : archives)
+    {
+        std::ifstream input(archive);
+        if (!input)
+        {
+            printf("Couldn't read %s\n", archive.c_str());
+            return 1;
+        }
+
+        size_t added = 0;
+        size_t skipped = 0;
+        GameRecord record;
+        bool isValid = false;
+        while (ReadGameRecord(input, record, isValid))
+        {
+            if (isValid && builder.AddGame(record))
+                ++added;
+            else
+                ++skipped;
+        }
+        printf("%s: %zu games, %zu skipped\n", archive.c_str(), added, skipped);
+    }
+
+    // Self-play games
+    if (selfPlayGames > 0)
+    {
+        std::ofstream gamesOut;
+        if (!gamesOutPath.empty())
+        {
+            gamesOut.open(gamesOutPath);
+            if (!gamesOut)
+            {
+                printf("Couldn't write %s\n", gamesOutPath.c_str());
+                return 1;
+            }
+        }
+
+        TranspositionTable table;
+        Engine engine(table);
+        SearchLimits limits;
+        limits.m_timeBudgetMs = moveTimeMs;
+        SelfPlayPlayer player{ engine, table, limits };
+        SelfPlaySettings settings;
+
+        auto begin = std::chrono::steady_clock::now();
+        size_t results[4] = {};
+        for (size_t game = 0; game < selfPlayGames; ++game)
+        {
+            GameRecord record = PlaySelfPlayGame(player, player, settings, game);
+            builder.AddGame(record);
+            ++results[(size_t)record.m_result];
+            if (gamesOut.is_open())
+                gamesOut << GameRecordToString(record);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        printf("Self-play: %zu games in %.1f s, dark %zu, light %zu, draws %zu\n", selfPlayGames, seconds,
+            results[(size_t)GameResult::kDarkWins], results[(size_t)GameResult::kLightWins], results[(size_t)GameResult::kDraw]);
+    }
+
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, error);
+
+    if (!builder.Save(path, minGames))
+    {
+        printf("Couldn't write %s\n", path.c_str());
+        return 1;
+    }
+    printf("Wrote %s: %zu games, %zu positions\n", path.c_str(), builder.GetGameCount(), builder.GetPositionCount());
+
+    if (verify)
+    {
+        OpeningBook book;
+        std::vector<OpeningBookEntry> entries = builder.BuildEntries(minGames);
+        if (!book.Load(path) || book.GetEntryCount() != entries.size())
+        {
+            printf("Couldn't load %s back\n", path.c_str());
+            return 1;
+        }
+
+        for (const OpeningBookEntry& entry : entries)
+        {
+            const OpeningBookEntry* pFirst = nullptr;
+            size_t count = book.Find(entry.m_key, pFirst);
+            bool isFound = false;
+            for (size_t i = 0; i < count; ++i)
+                isFound = isFound || memcmp(&pFirst[i], &entry, sizeof(entry)) == 0;
+
+            if (!isFound)
+            {
+                printf("Verify failed, entry %016llx missing\n", (unsigned long long)entry.m_key);
+                return 1;
+            }
+        }
+
+        printf("Verified %zu entries\n", entries.size());
+    }
+
+    return 0;
+}
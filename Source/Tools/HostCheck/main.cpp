@@ -0,0 +1,159 @@
+#include "Application/Application.h"
+#include "Application/Networking/Connection.h"
+#include "Checkers/MoveGenerator.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+// Host mode regression gate. Hosts a game in this process on kServerPort, with the engine playing dark, and plays
+// light against it from a plain connection.
+// hostcheck
+//  Fails unless a RESTART and a JOIN from the client are ignored: the host never restarts, and the client's
+//  move that follows them is played on the host's board
+
+//--------------------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------------------
+static constexpr int kTimeoutMs = 20000;    // The engine may think for a while before its first move
+static constexpr int kPollMs = 5;
+
+//--------------------------------------------------------------------------------------------------------------
+// Connect to the host and wait for it to accept, then stop blocking. Returns INVALID_SOCKET if it isn't there
+//--------------------------------------------------------------------------------------------------------------
+static SOCKET ConnectToHost()
+{
+    SOCKET socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((u_short)kServerPort);
+    addr.sin_addr.s_addr = inet_addr(pServerIp);
+
+    if (connect(socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        closesocket(socket);
+        return INVALID_SOCKET;
+    }
+    SetNonBlocking(socket);
+    return socket;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Play light against the host until our move comes back. Returns false on anything the host shouldn't do
+//--------------------------------------------------------------------------------------------------------------
+static bool PlayAgainstHost(Connection& conn)
+{
+    Position position;
+    bool hasBoard = false;
+    bool isMoveSent = false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kTimeoutMs);
+
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        if (!conn.Receive())
+        {
+            printf("FAILED: the host closed the connection\n");
+            return false;
+        }
+
+        AnyMessage message;
+        while (conn.PopMessage(message))
+        {
+            const Message& received = message.Get();
+            if (received.type == Message::Type::Restart)
+            {
+                printf("FAILED: the host restarted on the client's word\n");
+                return false;
+            }
+
+            if (received.type == Message::Type::Snapshot)
+            {
+                // A second board means our move was turned down
+                if (hasBoard)
+                {
+                    printf("FAILED: the host sent its board again\n");
+                    return false;
+                }
+                position = static_cast<const SnapshotMessage&>(received).m_position;
+                hasBoard = true;
+            }
+            else if (received.type == Message::Type::Play)
+            {
+                auto& play = static_cast<const PlayMessage&>(received);
+                if (!play.m_isHostCalling)
+                {
+                    printf("OK: ignored the client's RESTART and JOIN, played %s\n", MoveToString(play.m_move).c_str());
+                    return true;
+                }
+                ApplyMove(position, play.m_move);
+            }
+        }
+
+        // Our turn: what only the host may ask for first, then a legal move
+        if (hasBoard && !isMoveSent && position.m_sideToMove == CheckersColor::kLight)
+        {
+            MoveList moves;
+            if (GenerateMoves(position, CheckersColor::kLight, moves) == 0)
+            {
+                printf("FAILED: light has no move to play\n");
+                return false;
+            }
+
+            conn.Queue(RestartMessage());
+            conn.Queue(JoinMessage(0));
+            conn.Queue(PlayMessage(moves[0], 0));
+            isMoveSent = true;
+        }
+
+        while (conn.HasOutgoing())
+        {
+            if (!conn.Send())
+            {
+                printf("FAILED: couldn't send to the host\n");
+                return false;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(kPollMs));
+    }
+
+    printf("FAILED: timed out, %s\n", isMoveSent ? "our move never came back" : "it never became our turn");
+    return false;
+}
+
+int main(int argc, char*[])
+{
+    if (argc > 1)
+    {
+        printf("Usage: hostcheck\n");
+        return 1;
+    }
+
+    App app;
+    if (!app.Initialize())
+    {
+        app.Shutdown();
+        return 1;
+    }
+    std::thread game([&app]() { app.Run(); });
+
+    bool isPassed = false;
+    SOCKET socket = ConnectToHost();
+    if (socket == INVALID_SOCKET)
+    {
+        printf("FAILED: couldn't connect to the host on port %u\n", kServerPort);
+    }
+    else
+    {
+        Connection conn(socket, pServerIp);
+        isPassed = PlayAgainstHost(conn);
+        conn.Close();
+    }
+
+    app.Stop();
+    game.join();
+    app.Shutdown();
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+#include "Checkers/GameState.h"
+#include "Checkers/MoveGenerator.h"
+#include "Checkers/Position.h"
+#include "Engine/SearchPool.h"
+#include "Engine/TranspositionTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Headless move generator benchmark and regression gate.
+// perft [--depth N] [--divide] [--fen "<fen>"]... [--expect NODES] [--verify]
+//  -depth: How many plies to walk, 7 by default
+//  -divide: Print the node count below every root move
+//  -fen: Position to walk, may be repeated. The starting position if there is none
+//  -expect: Fail unless the last depth of every position counts this many nodes
+//  -verify: Fail unless the starting position matches the known counts, from depth 1 up to depth
+//
+// Search benchmark, to size hardware for the bot.
+// perft --search MS [--threads N] [--hash MB] [--fen "<fen>"]...
+//  -search: Search every position for MS milliseconds, once per thread count: 1, 2, 4... up to N
+//  -threads: Most threads to try, one per core by default
+//  -hash: Transposition table size in megabytes, TranspositionTable::kDefaultSizeMb by default
+
+//--------------------------------------------------------------------------------------------------------------
+// Known node counts from the starting position, index is depth
+//--------------------------------------------------------------------------------------------------------------
+static constexpr unsigned long long kStartPositionNodes[] =
+{
+    1ULL,
+    7ULL,
+    49ULL,
+    302ULL,
+    1469ULL,
+    7361ULL,
+    36768ULL,
+    179740ULL,
+    845931ULL,
+    3963680ULL,
+    18391564ULL,
+    85242128ULL,
+    388623673ULL,
+};
+static constexpr size_t kMaxVerifyDepth = sizeof(kStartPositionNodes) / sizeof(kStartPositionNodes[0]) - 1;
+
+//--------------------------------------------------------------------------------------------------------------
+// Count the leaves of the game tree below state's position, depth plies deep. Walks with make/unmake, so
+// state is back where it started when this returns
+//--------------------------------------------------------------------------------------------------------------
+static unsigned long long Perft(GameState& state, size_t depth)
+{
+    if (depth == 0)
+        return 1;
+
+    MoveList moves;
+    state.GetLegalMoves(moves);
+
+    // The last ply only needs counting
+    if (depth == 1)
+        return moves.Size();
+
+    unsigned long long nodes = 0;
+    for (const Move& move : moves)
+    {
+        state.MakeMove(move);
+        nodes += Perft(state, depth - 1);
+        state.UnmakeMove();
+    }
+    return nodes;
+}
+
+static unsigned long long Perft(const Position& position, size_t depth)
+{
+    GameState state;
+    state.SetPosition(position);
+    return Perft(state, depth);
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Walk position at every depth up to maxDepth and print the results. Returns the count at maxDepth
+//--------------------------------------------------------------------------------------------------------------
+static unsigned long long Run(const Position& position, size_t maxDepth, bool divide)
+{
+    printf("Position %s\n", position.ToFen().c_str());
+
+    unsigned long long nodes = 0;
+    for (size_t depth = 1; depth <= maxDepth; ++depth)
+    {
+        auto begin = std::chrono::steady_clock::now();
+
+        // Root moves are split out when dividing the last depth
+        nodes = 0;
+        if (divide && depth == maxDepth)
+        {
+            GameState state;
+            state.SetPosition(position);
+
+            MoveList moves;
+            state.GetLegalMoves(moves);
+            for (const Move& move : moves)
+            {
+                state.MakeMove(move);
+                unsigned long long moveNodes = Perft(state, depth - 1);
+                state.UnmakeMove();
+                printf("    %-12s %llu\n", MoveToString(move).c_str(), moveNodes);
+                nodes += moveNodes;
+            }
+        }
+        else
+        {
+            nodes = Perft(position, depth);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        double nodesPerSecond = (seconds > 0.0) ? (double)nodes / seconds : 0.0;
+        printf("  Depth %2zu: %12llu nodes %9.3f s %10.2f Mnodes/s\n", depth, nodes, seconds, nodesPerSecond / 1000000.0);
+    }
+    return nodes;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Search every position with more and more threads, print nodes/sec and how it scales from one thread
+//--------------------------------------------------------------------------------------------------------------
+static void RunSearchBenchmark(const std::vector<Position>& positions, uint32_t timeBudgetMs, size_t maxThreads, size_t tableSizeMb)
+{
+    TranspositionTable table(tableSizeMb);
+    SearchPool pool(table, 1);
+
+    SearchLimits limits;
+    limits.m_timeBudgetMs = timeBudgetMs;
+
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.emplace_back(threads);
+    threadCounts.emplace_back(maxThreads);
+
+    printf("Search %zu position(s), %u ms each, %zu MB table\n", positions.size(), timeBudgetMs, table.GetSizeBytes() / (1024 * 1024));
+
+    double baseNodesPerSecond = 0.0;
+    for (size_t threads : threadCounts)
+    {
+        pool.SetThreadCount(threads);
+
+        unsigned long long nodes = 0;
+        double seconds = 0.0;
+        size_t totalDepth = 0;
+        for (const Position& position : positions)
+        {
+            // Every position starts cold, so thread counts are compared fairly
+            table.Clear();
+            SearchResult result = pool.Search(position, limits);
+            nodes += result.m_nodes;
+            seconds += result.m_seconds;
+            totalDepth += result.m_depth;
+        }
+
+        double nodesPerSecond = (seconds > 0.0) ? (double)nodes / seconds : 0.0;
+        if (threads == 1)
+            baseNodesPerSecond = nodesPerSecond;
+        double scaling = (baseNodesPerSecond > 0.0) ? nodesPerSecond / baseNodesPerSecond : 0.0;
+
+        printf("  Threads %3zu: %12llu nodes %10.2f Mnodes/s %5.2fx  average depth %.1f\n",
+            threads, nodes, nodesPerSecond / 1000000.0, scaling, (double)totalDepth / (double)positions.size());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t depth = 7;
+    uint32_t searchMs = 0;
+    size_t maxThreads = (std::max)((size_t)1, (size_t)std::thread::hardware_concurrency());
+    size_t tableSizeMb = TranspositionTable::kDefaultSizeMb;
+    bool divide = false;
+    bool verify = false;
+    bool hasExpected = false;
+    unsigned long long expected = 0;
+    std::vector<Position> positions;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc)
+        {
+            depth = (size_t)strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--divide") == 0)
+        {
+            divide = true;
+        }
+        else if (strcmp(argv[i], "--verify") == 0)
+        {
+            verify = true;
+        }
+        else if (strcmp(argv[i], "--expect") == 0 && i + 1 < argc)
+        {
+            hasExpected = true;
+            expected = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--search") == 0 && i + 1 < argc)
+        {
+            searchMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            maxThreads = (std::max)((size_t)1, (size_t)strtoull(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc)
+        {
+            tableSizeMb = (size_t)strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--fen") == 0 && i + 1 < argc)
+        {
+            Position position;
+            if (!Position::FromFen(argv[++i], position))
+            {
+                printf("Invalid FEN: %s\n", argv[i]);
+                return 1;
+            }
+            positions.emplace_back(position);
+        }
+        else
+        {
+            printf("Usage: perft [--depth N] [--divide] [--fen \"<fen>\"]... [--expect NODES] [--verify]\n");
+            printf("       perft --search MS [--threads N] [--hash MB] [--fen \"<fen>\"]...\n");
+            return 1;
+        }
+    }
+
+    if (positions.empty())
+        positions.emplace_back(Position::StartPosition());
+
+    if (searchMs > 0)
+    {
+        RunSearchBenchmark(positions, searchMs, maxThreads, tableSizeMb);
+        return 0;
+    }
+
+    bool passed = true;
+
+    // Compare the starting position against the known counts
+    if (verify)
+    {
+        if (depth > kMaxVerifyDepth)
+        {
+            printf("Can only verify up to depth %zu\n", kMaxVerifyDepth);
+            return 1;
+        }
+
+        Position start = Position::StartPosition();
+        for (size_t verifyDepth = 1; verifyDepth <= depth; ++verifyDepth)
+        {
+            unsigned long long nodes = Perft(start, verifyDepth);
+            bool matched = (nodes == kStartPositionNodes[verifyDepth]);
+            printf("Verify depth %2zu: %12llu %s\n", verifyDepth, nodes, matched ? "OK" : "MISMATCH");
+            if (!matched)
+            {
+                printf("    expected %llu\n", kStartPositionNodes[verifyDepth]);
+                passed = false;
+            }
+        }
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    unsigned long long totalNodes = 0;
+
+    for (const Position& position : positions)
+    {
+        unsigned long long nodes = Run(position, depth, divide);
+        totalNodes += nodes;
+
+        if (hasExpected && nodes != expected)
+        {
+            printf("MISMATCH: expected %llu nodes, counted %llu\n", expected, nodes);
+            passed = false;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    printf("Total: %llu nodes at depth %zu in %.3f s\n", totalNodes, depth, seconds);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,302 @@
+#include "Checkers/GameRecord.h"
+#include "Engine/Engine.h"
+#include "Engine/SelfPlay.h"
+#include "Engine/Tablebase.h"
+#include "Engine/TranspositionTable.h"
+#include "Utils/Thread/WorkStealingPool.h"
+
+#include <chrono>
+#include <fstream>
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Tournament between two engine configurations, A and B, for tuning.
+// selfplay [--games N] [--threads N] [--a CONFIG] [--b CONFIG] [--hash MB] [--random-plies N] [--max-plies N]
+//          [--tablebase PATH] [--games-out PATH] [--expect-elo ELO]
+//  -games: How many games, 1000 by default. Rounded up to pairs, each opening is played once with A on each side
+//  -threads: Games played at once, one per core by default
+//  -a, -b: Comma separated key=value list: depth, movetime (milliseconds), man, king, advance, backrow.
+//          Both default to depth 6 and the engine's own evaluation weights
+//  -hash: Transposition table of every engine in megabytes, 4 by default
+//  -random-plies: Opening plies picked at random, 4 by default
+//  -max-plies: Games this long are draws, 200 by default
+//  -tablebase: Endgame tablebase both configurations use
+//  -games-out: Write every game as PDN, the book tool can build from it
+//  -expect-elo: Fail unless A is at least this much stronger than B, even at the low end of the confidence interval
+
+//--------------------------------------------------------------------------------------------------------------
+// One side of the tournament
+//--------------------------------------------------------------------------------------------------------------
+struct EngineConfig
+{
+    SearchLimits m_limits;
+    EvalWeights m_weights;
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Read "key=value,key=value" into config, returns false on an unknown key
+//--------------------------------------------------------------------------------------------------------------
+static bool ParseConfig(const std::string& text, EngineConfig& config)
+{
+    size_t begin = 0;
+    while (begin < text.size())
+    {
+        size_t end = text.find(',', begin);
+        if (end == std::string::npos)
+            end = text.size();
+
+        std::string item = text.substr(begin, end - begin);
+        begin = end + 1;
+
+        size_t equals = item.find('=');
+        if (equals == std::string::npos)
+            return false;
+
+        std::string key = item.substr(0, equals);
+        long value = strtol(item.c_str() + equals + 1, nullptr, 10);
+        if (key == "depth")
+            config.m_limits.m_maxDepth = (size_t)value;
+        else if (key == "movetime")
+            config.m_limits.m_timeBudgetMs = (uint32_t)value;
+        else if (key == "man")
+            config.m_weights.m_man = (int)value;
+        else if (key == "king")
+            config.m_weights.m_king = (int)value;
+        else if (key == "advance")
+            config.m_weights.m_advance = (int)value;
+        else if (key == "backrow")
+            config.m_weights.m_backRow = (int)value;
+        else
+            return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+// Engines of one worker thread, one per configuration, built the first time the worker plays a game
+//--------------------------------------------------------------------------------------------------------------
+struct WorkerEngines
+{
+    TranspositionTable m_tables[2];
+    std::unique_ptr<Engine> m_engines[2];
+
+    WorkerEngines(size_t tableSizeMb, const EngineConfig configs[2], const Tablebase* pTablebase)
+        : m_tables{ TranspositionTable(tableSizeMb), TranspositionTable(tableSizeMb) }
+    {
+        for (size_t i = 0; i < 2; ++i)
+        {
+            m_engines[i] = std::make_unique<Engine>(m_tables[i]);
+            m_engines[i]->SetWeights(configs[i].m_weights);
+            m_engines[i]->SetTablebase(pTablebase);
+        }
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------
+// Wins, draws and losses of A, with the Elo difference they imply
+//--------------------------------------------------------------------------------------------------------------
+struct TournamentScore
+{
+    size_t m_wins = 0;
+    size_t m_draws = 0;
+    size_t m_losses = 0;
+
+    size_t GetGameCount() const { return m_wins + m_draws + m_losses; }
+};
+
+// Elo difference that makes the stronger side score score on average
+static double ScoreToElo(double score)
+{
+    static constexpr double kClamp = 1e-6;
+    score = (std::min)((std::max)(score, kClamp), 1.0 - kClamp);
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+// Elo difference of A, and the half width of its 95% confidence interval
+static void GetElo(const TournamentScore& score, double& elo, double& errorMargin)
+{
+    double games = (double)score.GetGameCount();
+    double mean = (score.m_wins + 0.5 * score.m_draws) / games;
+
+    // Standard deviation of a single game's score, then of the mean over every game
+    double variance = (score.m_wins * (1.0 - mean) * (1.0 - mean)
+        + score.m_draws * (0.5 - mean) * (0.5 - mean)
+        + score.m_losses * mean * mean) / games;
+    double deviation = sqrt(variance / games);
+
+    static constexpr double k95Percent = 1.959964;
+    elo = ScoreToElo(mean);
+    errorMargin = (ScoreToElo(mean + k95Percent * deviation) - ScoreToElo(mean - k95Percent * deviation)) / 2.0;
+}
+
+static void PrintScore(const TournamentScore& score, double seconds)
+{
+    double elo = 0.0;
+    double errorMargin = 0.0;
+    GetElo(score, elo, errorMargin);
+    printf("Games %zu: A %zu W / %zu D / %zu L, Elo %+.1f +/- %.1f, %.2f games/s\n",
+        score.GetGameCount(), score.m_wins, score.m_draws, score.m_losses, elo, errorMargin, score.GetGameCount() / seconds);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t gameCount = 1000;
+    size_t threadCount = 0;
+    EngineConfig configs[2];
+    configs[0].m_limits.m_maxDepth = configs[1].m_limits.m_maxDepth = 6;
+    size_t tableSizeMb = 4;
+    SelfPlaySettings settings;
+    std::string tablebasePath;
+    std::string gamesOutPath;
+    bool hasExpectedElo = false;
+    double expectedElo = 0.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc)
+        {
+            gameCount = (size_t)strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threadCount = (size_t)strtoull(argv[++i], nullptr, 10);
+        }
+        else if ((strcmp(argv[i], "--a") == 0 || strcmp(argv[i], "--b") == 0) && i + 1 < argc)
+        {
+            EngineConfig& config = configs[argv[i][2] == 'a' ? 0 : 1];
+            if (!ParseConfig(argv[++i], config))
+            {
+                printf("Bad config %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc)
+        {
+            tableSizeMb = (size_t)strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--random-plies") == 0 && i + 1 < argc)
+        {
+            settings.m_randomPlies = (size_t)strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--max-plies") == 0 && i + 1 < argc)
+        {
+            settings.m_maxPlies = (size_t)strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--tablebase") == 0 && i + 1 < argc)
+        {
+            tablebasePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--games-out") == 0 && i + 1 < argc)
+        {
+            gamesOutPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--expect-elo") == 0 && i + 1 < argc)
+        {
+            hasExpectedElo = true;
+            expectedElo = strtod(argv[++i], nullptr);
+        }
+        else
+        {
+            printf("Usage: selfplay [--games N] [--threads N] [--a CONFIG] [--b CONFIG] [--hash MB] [--random-plies N] [--max-plies N] [--tablebase PATH] [--games-out PATH] [--expect-elo ELO]\n");
+            return 1;
+        }
+    }
+
+    // No games, no score to take the Elo of
+    if (gameCount == 0)
+    {
+        printf("Nothing to play, --games must be at least 1\n");
+        return 1;
+    }
+    gameCount += gameCount % 2;
+
+    Tablebase tablebase;
+    if (!tablebasePath.empty() && !tablebase.Load(tablebasePath))
+    {
+        printf("Couldn't load %s\n", tablebasePath.c_str());
+        return 1;
+    }
+
+    std::ofstream gamesOut;
+    if (!gamesOutPath.empty())
+    {
+        gamesOut.open(gamesOutPath);
+        if (!gamesOut)
+        {
+            printf("Couldn't write %s\n", gamesOutPath.c_str());
+            return 1;
+        }
+    }
+
+    WorkStealingPool pool(threadCount);
+    std::vector<std::unique_ptr<WorkerEngines>> workers(pool.GetThreadCount());
+    const Tablebase* pTablebase = tablebase.IsLoaded() ? &tablebase : nullptr;
+    printf("Playing %zu games on %zu threads\n", gameCount, pool.GetThreadCount());
+
+    std::mutex resultMutex;
+    TournamentScore score;
+    size_t progressStep = (std::max)((size_t)1, gameCount / 10);
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t game = 0; game < gameCount; ++game)
+    {
+        pool.Submit([&, game](size_t workerIndex)
+        {
+            std::unique_ptr<WorkerEngines>& pWorker = workers[workerIndex];
+            if (!pWorker)
+                pWorker = std::make_unique<WorkerEngines>(tableSizeMb, configs, pTablebase);
+
+            // Both games of a pair open the same way, A is dark in the first one
+            bool isADark = (game % 2 == 0);
+            SelfPlayPlayer players[2] =
+            {
+                { *pWorker->m_engines[0], pWorker->m_tables[0], configs[0].m_limits },
+                { *pWorker->m_engines[1], pWorker->m_tables[1], configs[1].m_limits },
+            };
+            for (TranspositionTable& table : pWorker->m_tables)
+                table.Clear();
+
+            const SelfPlayPlayer& dark = isADark ? players[0] : players[1];
+            const SelfPlayPlayer& light = isADark ? players[1] : players[0];
+            GameRecord record = PlaySelfPlayGame(dark, light, settings, game / 2);
+
+            double scoreOfA = GetGameScore(record.m_result, isADark ? CheckersColor::kDark : CheckersColor::kLight);
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if (scoreOfA == 1.0)
+                ++score.m_wins;
+            else if (scoreOfA == 0.0)
+                ++score.m_losses;
+            else
+                ++score.m_draws;
+
+            if (gamesOut.is_open())
+                gamesOut << GameRecordToString(record);
+
+            if (score.GetGameCount() % progressStep == 0 && score.GetGameCount() < gameCount)
+                PrintScore(score, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+        });
+    }
+    pool.Wait();
+
+    PrintScore(score, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+
+    if (hasExpectedElo)
+    {
+        double elo = 0.0;
+        double errorMargin = 0.0;
+        GetElo(score, elo, errorMargin);
+        if (elo - errorMargin < expectedElo)
+        {
+            printf("MISMATCH: expected A at least %+.1f Elo over B, got %+.1f +/- %.1f\n", expectedElo, elo, errorMargin);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "Engine/Tablebase.h"
+#include "Engine/TablebaseBuilder.h"
+
+#include <chrono>
+#include <filesystem>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+// Endgame tablebase generator.
+// tablebase [--pieces N] [--out PATH] [--verify]
+//  -pieces: Solve every position with up to N pieces, 4 by default. Each extra piece costs about 25 times more
+//  -out: Where to write the file, kTablebasePath by default
+//  -verify: Check every position against its children and reload the written file before exiting
+
+int main(int argc, char* argv[])
+{
+    size_t maxPieces = 4;
+    std::string path = kTablebasePath;
+    bool verify = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--pieces") == 0 && i + 1 < argc)
+        {
+            maxPieces = (size_t)strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--verify") == 0)
+        {
+            verify = true;
+        }
+        else
+        {
+            printf("Usage: tablebase [--pieces N] [--out PATH] [--verify]\n");
+            return 1;
+        }
+    }
+
+    if (maxPieces < 2 || maxPieces > kMaxTablebasePieces)
+    {
+        printf("Pieces must be between 2 and %zu\n", kMaxTablebasePieces);
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    unsigned long long totalPositions = 0;
+
+    TablebaseBuilder builder;
+    bool isBuilt = builder.Build(maxPieces, [&totalPositions](const Material& material, uint64_t positions, size_t passes)
+    {
+        printf("  %uM %uK v %uM %uK: %12llu positions, %3zu passes\n",
+            material.m_darkMen, material.m_darkKings, material.m_lightMen, material.m_lightKings, (unsigned long long)positions, passes);
+        totalPositions += positions;
+    });
+
+    if (!isBuilt)
+    {
+        printf("The next slice has positions past %zu plies, the file can't hold them\n", kMaxTablebaseDistance);
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    printf("Solved %llu positions up to %zu pieces in %.1f s\n", totalPositions, maxPieces, seconds);
+
+    if (verify && !builder.Verify())
+    {
+        printf("Verify failed\n");
+        return 1;
+    }
+
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, error);
+
+    if (!builder.Save(path))
+    {
+        printf("Couldn't write %s\n", path.c_str());
+        return 1;
+    }
+    printf("Wrote %s\n", path.c_str());
+
+    if (verify)
+    {
+        Tablebase tablebase;
+        if (!tablebase.Load(path) || tablebase.GetMaxPieces() != maxPieces)
+        {
+            printf("Couldn't load %s back\n", path.c_str());
+            return 1;
+        }
+        printf("Verified\n");
+    }
+
+    return 0;
+}
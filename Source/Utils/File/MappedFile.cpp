@@ -0,0 +1,105 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+#ifdef _WIN32
+	: m_fileHandle{ INVALID_HANDLE_VALUE }
+	, m_mappingHandle{ nullptr }
+#else
+	: m_fileDescriptor{ -1 }
+#endif
+	, m_pData{ nullptr }
+	, m_size{ 0 }
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+//-----------------------------------------------------------------------------------------------------------
+// Map the whole file at path, returns false if it can't be opened or is empty
+//-----------------------------------------------------------------------------------------------------------
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+#ifdef _WIN32
+	m_fileHandle = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(m_fileHandle, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_mappingHandle = ::CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mappingHandle)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = static_cast<const uint8_t*>(::MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	m_size = (size_t)size.QuadPart;
+#else
+	m_fileDescriptor = ::open(path.c_str(), O_RDONLY);
+	if (m_fileDescriptor < 0)
+		return false;
+
+	struct stat status;
+	if (::fstat(m_fileDescriptor, &status) != 0 || status.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* pData = ::mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, m_fileDescriptor, 0);
+	m_pData = (pData == MAP_FAILED) ? nullptr : static_cast<const uint8_t*>(pData);
+	m_size = (size_t)status.st_size;
+#endif
+
+	if (!m_pData)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------
+// Unmap and close the file, safe to call when nothing is open
+//-----------------------------------------------------------------------------------------------------------
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_pData)
+		::UnmapViewOfFile(m_pData);
+	if (m_mappingHandle)
+		::CloseHandle(m_mappingHandle);
+	if (m_fileHandle != INVALID_HANDLE_VALUE)
+		::CloseHandle(m_fileHandle);
+	m_mappingHandle = nullptr;
+	m_fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (m_pData)
+		::munmap(const_cast<uint8_t*>(m_pData), m_size);
+	if (m_fileDescriptor >= 0)
+		::close(m_fileDescriptor);
+	m_fileDescriptor = -1;
+#endif
+	m_pData = nullptr;
+	m_size = 0;
+}
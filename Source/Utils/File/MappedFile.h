@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//-----------------------------------------------------------------------------------------------------------
+// Read-only memory mapped file. Every process mapping the same file shares the same physical pages
+//-----------------------------------------------------------------------------------------------------------
+class MappedFile
+{
+#ifdef _WIN32
+	void* m_fileHandle;		// HANDLE, kept as void* so Windows.h stays out of this header
+	void* m_mappingHandle;
+#else
+	int m_fileDescriptor;
+#endif
+	const uint8_t* m_pData;
+	size_t m_size;
+
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const { return m_pData != nullptr; }
+	const uint8_t* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_size; }
+};
@@ -1,6 +1,32 @@
 #include "Log.h"
+#include <ctime>
 #include <time.h>
 
+#ifndef _WIN32
+#include <unistd.h>
+
+//-----------------------------------------------------------------------------------------------------------
+// Console colors as ANSI escape codes. Color's values are Windows console attributes: blue 1, green 2, red 4,
+// bright 8 for the text, and the same shifted up by 4 for the background. Nothing is written if stdout isn't a terminal
+//-----------------------------------------------------------------------------------------------------------
+static void SetTerminalColor(int attributes)
+{
+	static const bool s_isTerminal = isatty(STDOUT_FILENO);
+	if (!s_isTerminal)
+		return;
+
+	// Blue, green, red bits to ANSI's red, green, blue order
+	static constexpr int kAnsiColor[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+	int text = attributes & 0xF;
+	int background = (attributes >> 4) & 0xF;
+
+	std::cout << "\033[0;" << ((text & 8) ? 90 : 30) + kAnsiColor[text & 7];
+	if (background != 0)
+		std::cout << ";" << ((background & 8) ? 100 : 40) + kAnsiColor[background & 7];
+	std::cout << "m";
+}
+#endif
+
 Log& Log::Get()
 {
     static Log s_instance;
@@ -9,7 +35,11 @@ Log& Log::Get()
 
 void Log::SetColor(Color color)
 {
+#ifdef _WIN32
     SetConsoleTextAttribute(m_consoleHandle, static_cast<int>(color));
+#else
+    SetTerminalColor(static_cast<int>(color));
+#endif
 }
 
 void Log::LogInfo(std::string category, int line, const char* file, const char* format, ...)
@@ -49,14 +79,18 @@ void Log::PrintInColor(Color color, const char* format, ...)
 
 	va_end(args);
 
-	SetConsoleTextAttribute(m_consoleHandle, static_cast<int>(color));
+	SetColor(color);
 	std::cout << messageBuffer;
-	SetConsoleTextAttribute(m_consoleHandle, static_cast<int>(m_currentColor));
+	SetColor(m_currentColor);
 }
 
 Log::Log()
+#ifdef _WIN32
     : m_consoleHandle{ GetStdHandle(STD_OUTPUT_HANDLE) }
     , m_currentColor{ Color::kLightGray }
+#else
+    : m_currentColor{ Color::kLightGray }
+#endif
 {
     m_category.insert({"Info", Color::kWhite});
     m_category.insert({"Error", Color::kRed});
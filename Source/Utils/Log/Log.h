@@ -1,5 +1,9 @@
 #pragma once
+#ifdef _WIN32
 #include <Windows.h>
+#endif
+#include "Utils/Platform/SecureCrt.h"
+
 #include <iostream>
 #include <string>
 #include <unordered_map>
@@ -34,14 +38,16 @@ public:
 
 		// Background color
 		kBlueBackgroundWhiteText = 63,
-		kRedBackgroundBlackText = BACKGROUND_RED,
+		kRedBackgroundBlackText = 64,
 		kGrayBackgroundBlackText = 128,
 		kGrayBackgroundYellowText = 142,
 		kWhiteBackgroundBlackText = 240,
 	};
 
 private:
+#ifdef _WIN32
 	HANDLE m_consoleHandle;
+#endif
 	Color m_currentColor;
 	std::unordered_map<std::string, Color> m_category;     // map for log categories
 
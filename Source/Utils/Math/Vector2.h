@@ -91,7 +91,7 @@ inline  Vector2 Vector2::Unit()
 //---------------------------------------------------------------------------------------------------------------------
 inline  float Vector2::DistanceTo(const Vector2 other) const
 {
-	return std::sqrtf(DistanceToSquared(other));
+	return std::sqrt(DistanceToSquared(other));
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -111,7 +111,7 @@ inline  float Vector2::DistanceToSquared(const Vector2 other) const
 //---------------------------------------------------------------------------------------------------------------------
 inline float Vector2::Length() const
 {
-	return std::sqrtf(SquaredLength());
+	return std::sqrt(SquaredLength());
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+//-----------------------------------------------------------------------------------------------------------
+// Stand-ins for the MSVC "_s" functions the game uses, so it also builds with gcc and clang.
+// Buffers are arrays, their size comes from the type the same way the MSVC template overloads do it
+//-----------------------------------------------------------------------------------------------------------
+#ifndef _MSC_VER
+template <size_t kSize>
+inline int vsprintf_s(char (&buffer)[kSize], const char* format, va_list args)
+{
+	return vsnprintf(buffer, kSize, format, args);
+}
+
+template <size_t kSize>
+inline int sprintf_s(char (&buffer)[kSize], const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(buffer, kSize, format, args);
+	va_end(args);
+	return length;
+}
+
+// Only numbers are scanned, which need no buffer sizes
+#define sscanf_s sscanf
+
+inline int localtime_s(struct tm* pTime, const time_t* pClock)
+{
+	return localtime_r(pClock, pTime) ? 0 : -1;
+}
+#endif
@@ -0,0 +1,134 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+// Which worker of which pool the calling thread is, so tasks submitted from a task stay on the same worker
+static thread_local const WorkStealingPool* s_pCurrentPool = nullptr;
+static thread_local size_t s_currentWorker = 0;
+
+//-----------------------------------------------------------------------------------------------------------
+// Start the workers
+//		-threadCount: 0 for one per core
+//-----------------------------------------------------------------------------------------------------------
+WorkStealingPool::WorkStealingPool(size_t threadCount)
+	: m_workers{}
+	, m_threads{}
+	, m_queuedCount{ 0 }
+	, m_pendingCount{ 0 }
+	, m_nextWorker{ 0 }
+	, m_isStopping{ false }
+{
+	if (threadCount == 0)
+		threadCount = (std::max)((size_t)1, (size_t)std::thread::hardware_concurrency());
+
+	for (size_t i = 0; i < threadCount; ++i)
+		m_workers.emplace_back(std::make_unique<Worker>());
+
+	m_threads.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i)
+		m_threads.emplace_back([this, i]() { Run(i); });
+}
+
+//-----------------------------------------------------------------------------------------------------------
+// Finish every queued task, then stop the workers
+//-----------------------------------------------------------------------------------------------------------
+WorkStealingPool::~WorkStealingPool()
+{
+	Wait();
+	{
+		std::lock_guard<std::mutex> lock(m_waitMutex);
+		m_isStopping = true;
+	}
+	m_wakeUp.notify_all();
+
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+//-----------------------------------------------------------------------------------------------------------
+// Queue a task. From a worker it goes on that worker's own queue, from anywhere else queues take turns
+//-----------------------------------------------------------------------------------------------------------
+void WorkStealingPool::Submit(Task task)
+{
+	std::unique_lock<std::mutex> lock(m_waitMutex);
+	size_t workerIndex = (s_pCurrentPool == this) ? s_currentWorker : m_nextWorker++ % m_workers.size();
+	{
+		std::lock_guard<std::mutex> queueLock(m_workers[workerIndex]->m_mutex);
+		m_workers[workerIndex]->m_tasks.emplace_back(std::move(task));
+	}
+	++m_queuedCount;
+	++m_pendingCount;
+	lock.unlock();
+
+	m_wakeUp.notify_one();
+}
+
+//-----------------------------------------------------------------------------------------------------------
+// Block until every task submitted so far, and every task they submitted, is done. Not callable from a task
+//-----------------------------------------------------------------------------------------------------------
+void WorkStealingPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_waitMutex);
+	m_idle.wait(lock, [this]() { return m_pendingCount == 0; });
+}
+
+//-----------------------------------------------------------------------------------------------------------
+// Worker loop: run tasks until the pool stops, sleep while there are none
+//-----------------------------------------------------------------------------------------------------------
+void WorkStealingPool::Run(size_t workerIndex)
+{
+	s_pCurrentPool = this;
+	s_currentWorker = workerIndex;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_waitMutex);
+			m_wakeUp.wait(lock, [this]() { return m_queuedCount > 0 || m_isStopping; });
+			if (m_queuedCount == 0)
+				return;
+			--m_queuedCount;
+		}
+
+		// The count reserved one task, some queue holds it even if another worker emptied the one it went to
+		Task task;
+		while (!PopTask(workerIndex, task))
+			std::this_thread::yield();
+
+		task(workerIndex);
+
+		std::lock_guard<std::mutex> lock(m_waitMutex);
+		if (--m_pendingCount == 0)
+			m_idle.notify_all();
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------
+// Take the newest task of this worker, or else steal the oldest task of the next worker that has one
+//-----------------------------------------------------------------------------------------------------------
+bool WorkStealingPool::PopTask(size_t workerIndex, Task& task)
+{
+	{
+		Worker& worker = *m_workers[workerIndex];
+		std::lock_guard<std::mutex> lock(worker.m_mutex);
+		if (!worker.m_tasks.empty())
+		{
+			task = std::move(worker.m_tasks.back());
+			worker.m_tasks.pop_back();
+			return true;
+		}
+	}
+
+	for (size_t offset = 1; offset < m_workers.size(); ++offset)
+	{
+		Worker& victim = *m_workers[(workerIndex + offset) % m_workers.size()];
+		std::lock_guard<std::mutex> lock(victim.m_mutex);
+		if (!victim.m_tasks.empty())
+		{
+			task = std::move(victim.m_tasks.front());
+			victim.m_tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------------------------------------
+// Fixed set of worker threads, each with its own task queue. A worker takes its newest task first, and when
+// its queue runs dry it steals the oldest task of another worker, so uneven tasks still keep every core busy
+//-----------------------------------------------------------------------------------------------------------
+class WorkStealingPool
+{
+public:
+	// Runs on a worker, workerIndex tells which so tasks can keep per-worker state without locking
+	using Task = std::function<void(size_t workerIndex)>;
+
+private:
+	struct Worker
+	{
+		std::mutex m_mutex;
+		std::deque<Task> m_tasks;
+	};
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_waitMutex;
+	std::condition_variable m_wakeUp;		// A task was queued, or the pool is stopping
+	std::condition_variable m_idle;			// Every task is done
+	size_t m_queuedCount;					// Guarded by m_waitMutex
+	size_t m_pendingCount;					// Queued or running, guarded by m_waitMutex
+	size_t m_nextWorker;					// Where the next task from outside goes, guarded by m_waitMutex
+	bool m_isStopping;
+
+public:
+	WorkStealingPool(size_t threadCount = 0);
+	~WorkStealingPool();
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	void Submit(Task task);
+	void Wait();
+	size_t GetThreadCount() const { return m_threads.size(); }
+
+private:
+	void Run(size_t workerIndex);
+	bool PopTask(size_t workerIndex, Task& task);
+};